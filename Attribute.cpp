@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Attribute.cpp
+//! \brief  The Attribute class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Attribute.hpp"
+#include "Attributes.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the value. If the attribute belongs to a collection it's notified, in
+//! the same way as if the value had been set through the collection.
+
+void Attribute::setValue(const tstring& value_)
+{
+	if (m_owner == nullptr)
+	{
+		m_value = value_;
+		return;
+	}
+
+	const tstring oldValue = m_value;
+
+	m_value = value_;
+
+	m_owner->notifyChanged(m_name, &oldValue, m_value);
+}
+
+//namespace XML
+}
@@ -14,9 +14,14 @@
 namespace XML
 {
 
+// Forward declarations.
+class Attributes;
+
 ////////////////////////////////////////////////////////////////////////////////
 //! An attribute. A collection cannot have duplicates so no write access to the
-//! name is provided.
+//! name is provided. An attribute belongs to at most one collection, which is
+//! notified when the value is set so that the owning node and document see
+//! the change.
 
 class Attribute
 {
@@ -27,6 +32,9 @@ public:
 	//! Construction from a name and value pair.
 	Attribute(const tstring& name, const tstring& value);
 
+	//! Copy constructor.
+	Attribute(const Attribute& rhs);
+
 	//
 	// Properties.
 	//
@@ -44,8 +52,19 @@ private:
 	//
 	// Members.
 	//
-	tstring	m_name;			//!< The attribute name.
-	tstring	m_value;		//!< The attribute value.
+	tstring		m_name;			//!< The attribute name.
+	tstring		m_value;		//!< The attribute value.
+	Attributes*	m_owner;		//!< The collection the attribute belongs to.
+
+	//
+	// Friends.
+	//
+
+	//! Allow the collection to take ownership of the attribute.
+	friend class Attributes;
+
+	// NotAssignable.
+	Attribute& operator=(const Attribute&);
 };
 
 //! The default Attribute smart-pointer type.
@@ -55,7 +74,7 @@ typedef Core::SharedPtr<Attribute> AttributePtr;
 //! Default constructor.
 
 inline Attribute::Attribute()
-	: m_name(), m_value()
+	: m_name(), m_value(), m_owner(nullptr)
 {
 }
 
@@ -63,7 +82,15 @@ inline Attribute::Attribute()
 //! Construction from a name and value pair.
 
 inline Attribute::Attribute(const tstring& name_, const tstring& value_)
-	: m_name(name_), m_value(value_)
+	: m_name(name_), m_value(value_), m_owner(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy constructor. The copy doesn't belong to a collection.
+
+inline Attribute::Attribute(const Attribute& rhs)
+	: m_name(rhs.m_name), m_value(rhs.m_value), m_owner(nullptr)
 {
 }
 
@@ -83,14 +110,6 @@ inline const tstring& Attribute::value() const
 	return m_value;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-//! Set the value.
-
-inline void Attribute::setValue(const tstring& value_)
-{
-	m_value = value_;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Create an element with a specified name.
 
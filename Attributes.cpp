@@ -5,6 +5,8 @@
 
 #include "Common.hpp"
 #include "Attributes.hpp"
+#include "Document.hpp"
+#include "ElementNode.hpp"
 #include <Core/InvalidArgException.hpp>
 #include <Core/StringUtils.hpp>
 #include <algorithm>
@@ -38,6 +40,7 @@ struct FindByName : public std::unary_function<AttributePtr, bool>
 
 Attributes::Attributes()
 	: m_attributes()
+	, m_owner(nullptr)
 {
 }
 
@@ -46,8 +49,23 @@ Attributes::Attributes()
 
 Attributes::Attributes(AttributePtr attribute)
 	: m_attributes()
+	, m_owner(nullptr)
 {
-	m_attributes.push_back(attribute);
+	m_attributes.push_back(adopt(attribute));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy constructor. The copy doesn't belong to a node and holds copies of the
+//! attributes.
+
+Attributes::Attributes(const Attributes& rhs)
+	: m_attributes()
+	, m_owner(nullptr)
+{
+	m_attributes.reserve(rhs.m_attributes.size());
+
+	for (Container::const_iterator it = rhs.m_attributes.begin(); it != rhs.m_attributes.end(); ++it)
+		m_attributes.push_back(adopt(*it));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,6 +73,31 @@ Attributes::Attributes(AttributePtr attribute)
 
 Attributes::~Attributes()
 {
+	release(m_attributes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Assignment operator. The attributes still belong to the same node and are
+//! copies of those assigned.
+
+Attributes& Attributes::operator=(const Attributes& rhs)
+{
+	if (&rhs != this)
+	{
+		Container attributes;
+
+		attributes.reserve(rhs.m_attributes.size());
+
+		for (Container::const_iterator it = rhs.m_attributes.begin(); it != rhs.m_attributes.end(); ++it)
+			attributes.push_back(adopt(*it));
+
+		m_attributes.swap(attributes);
+		release(attributes);
+
+		notifyReplaced(attributes);
+	}
+
+	return *this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,7 +105,12 @@ Attributes::~Attributes()
 
 void Attributes::clear()
 {
-	m_attributes.clear();
+	Container attributes;
+
+	m_attributes.swap(attributes);
+	release(attributes);
+
+	notifyReplaced(attributes);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -78,9 +126,19 @@ void Attributes::set(const AttributePtr& attribute)
 	AttributePtr existing = find(attribute->name());
 
 	if (existing.get() != nullptr)
-		existing->setValue(attribute->value());
+	{
+		const tstring oldValue = existing->m_value;
+
+		existing->m_value = attribute->value();
+
+		notifyChanged(attribute->name(), &oldValue, attribute->value());
+	}
 	else
-		m_attributes.push_back(attribute);
+	{
+		m_attributes.push_back(adopt(attribute));
+
+		notifyChanged(attribute->name(), nullptr, attribute->value());
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,9 +153,19 @@ void Attributes::set(const tstring& name, const tstring& value)
 	AttributePtr existing = find(name);
 
 	if (existing.get() != nullptr)
-		existing->setValue(value);
+	{
+		const tstring oldValue = existing->m_value;
+
+		existing->m_value = value;
+
+		notifyChanged(name, &oldValue, value);
+	}
 	else
-		m_attributes.push_back(makeAttribute(name, value));
+	{
+		m_attributes.push_back(adopt(makeAttribute(name, value)));
+
+		notifyChanged(name, nullptr, value);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -136,5 +204,103 @@ const tstring& Attributes::getValue(const tstring& name) const
 	return get(name)->value();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Find the value for an attribute by its name, or return null if not found.
+//! No reference to the attribute is taken, so this can be called by more than
+//! one thread at a time.
+
+const tstring* Attributes::findValue(const tstring& name) const
+{
+	for (Container::const_iterator it = m_attributes.begin(); it != m_attributes.end(); ++it)
+	{
+		if ((*it)->name() == name)
+			return &(*it)->value();
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Take ownership of an attribute. An attribute can only belong to one
+//! collection, so one that's already owned is copied.
+
+AttributePtr Attributes::adopt(const AttributePtr& attribute)
+{
+	AttributePtr adopted = attribute;
+
+	if (adopted->m_owner != nullptr)
+		adopted = AttributePtr(new Attribute(*attribute));
+
+	adopted->m_owner = this;
+
+	return adopted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release ownership of a set of attributes, which may still be referenced
+//! elsewhere.
+
+void Attributes::release(const Container& attributes)
+{
+	for (Container::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+		(*it)->m_owner = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Notify the owning node, if any, that a single attribute has been set. If
+//! the node is an element in a document, the document is also notified so that
+//! it can keep its indexes up-to-date.
+
+void Attributes::notifyChanged(const tstring& name, const tstring* oldValue, const tstring& newValue)
+{
+	if (m_owner == nullptr)
+		return;
+
+	m_owner->notifyModified();
+
+	Document* document = ownerDocument();
+
+	if (document != nullptr)
+		document->onAttributeChanged(static_cast<ElementNode*>(m_owner), name, oldValue, &newValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Notify the owning node, if any, that all the attributes have been replaced.
+//! The document is told of each previous attribute being removed and each
+//! current one being added, so that it only updates the affected index entries.
+
+void Attributes::notifyReplaced(const Container& previous)
+{
+	if (m_owner == nullptr)
+		return;
+
+	m_owner->notifyModified();
+
+	Document* document = ownerDocument();
+
+	if (document == nullptr)
+		return;
+
+	ElementNode* element = static_cast<ElementNode*>(m_owner);
+
+	for (Container::const_iterator it = previous.begin(); it != previous.end(); ++it)
+		document->onAttributeChanged(element, (*it)->name(), &(*it)->value(), nullptr);
+
+	for (Container::const_iterator it = m_attributes.begin(); it != m_attributes.end(); ++it)
+		document->onAttributeChanged(element, (*it)->name(), nullptr, &(*it)->value());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the document that indexes the owning node, which is only ever an
+//! element's, if any.
+
+Document* Attributes::ownerDocument() const
+{
+	if (m_owner->type() != ELEMENT_NODE)
+		return nullptr;
+
+	return m_owner->ownerDocument();
+}
+
 //namespace XML
 }
@@ -17,8 +17,15 @@
 namespace XML
 {
 
+// Forward declarations.
+class Node;
+class Document;
+
 ////////////////////////////////////////////////////////////////////////////////
-//! The collection of attributes for a node.
+//! The collection of attributes for a node. When the collection belongs to a
+//! node in a document, the document is notified as attributes are set, whether
+//! through the collection or through an Attribute it holds. Each collection
+//! holds its own Attribute objects, so a copy is independent of the original.
 
 class Attributes
 {
@@ -32,17 +39,28 @@ public:
 	//! Construction with a single attribute.
 	Attributes(AttributePtr attribute);
 
+	//! Copy constructor.
+	Attributes(const Attributes& rhs);
+
 	//! Destructor.
 	~Attributes();
+
+	//
+	// Operators.
+	//
+
+	//! Assignment operator.
+	Attributes& operator=(const Attributes& rhs);
 	
 	//
 	// Types.
 	//
 
-	//! The iterator type.
-	typedef Container::const_iterator const_iterator;
 	//! The const iterator type.
-	typedef Container::iterator iterator;
+	typedef Container::const_iterator const_iterator;
+	//! The iterator type. Attributes are only added or removed through the
+	//! collection, so this is also read-only.
+	typedef Container::const_iterator iterator;
 
 	//
 	// Properties.
@@ -60,12 +78,6 @@ public:
 	//! Get the end iterator for the collection.
 	const_iterator end() const;
 
-	//! Get the start iterator for the collection.
-	iterator begin();
-
-	//! Get the end iterator for the collection.
-	iterator end();
-
 	//
 	// Methods.
 	//
@@ -88,11 +100,47 @@ public:
 	//! Get the value for an attribute by its name or throw if not found.
 	const tstring& getValue(const tstring& name) const; // throw(InvalidArgException)
 
+	//! Find the value for an attribute by its name.
+	const tstring* findValue(const tstring& name) const;
+
 private:
 	//
 	// Members.
 	//
 	Container	m_attributes;		//!< The underlying container.
+	Node*		m_owner;			//!< The node the attributes belong to.
+
+	//
+	// Internal methods.
+	//
+
+	//! Set the node the attributes belong to.
+	void setOwner(Node* owner);
+
+	//! Take ownership of an attribute, copying it if it's already owned.
+	AttributePtr adopt(const AttributePtr& attribute);
+
+	//! Release ownership of a set of attributes.
+	static void release(const Container& attributes);
+
+	//! Notify the owning node that a single attribute has been set.
+	void notifyChanged(const tstring& name, const tstring* oldValue, const tstring& newValue);
+
+	//! Notify the owning node that all the attributes have been replaced.
+	void notifyReplaced(const Container& previous);
+
+	//! Get the document that indexes the owning node, if any.
+	Document* ownerDocument() const;
+
+	//
+	// Friends.
+	//
+
+	//! Allow the nodes with attributes to set the owner.
+	friend class ElementNode;
+	friend class ProcessingNode;
+	//! Allow an attribute to notify the collection when its value is set.
+	friend class Attribute;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -128,19 +176,11 @@ inline Attributes::const_iterator Attributes::end() const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the start iterator for the collection.
+//! Set the node the attributes belong to.
 
-inline Attributes::iterator Attributes::begin()
+inline void Attributes::setOwner(Node* owner)
 {
-	return m_attributes.begin();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-//! Get the end iterator for the collection.
-
-inline Attributes::iterator Attributes::end()
-{
-	return m_attributes.end();
+	m_owner = owner;
 }
 
 //namespace XML
@@ -13,7 +13,8 @@ namespace XML
 //! Default constructor.
 
 CDataNode::CDataNode()
-	: m_text()
+	: Node(NODE_TYPE)
+	, m_text()
 {
 }
 
@@ -21,7 +22,8 @@ CDataNode::CDataNode()
 //! Construction from the text string.
 
 CDataNode::CDataNode(const tstring& text_)
-	: m_text(text_)
+	: Node(NODE_TYPE)
+	, m_text(text_)
 {
 }
 
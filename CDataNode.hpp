@@ -22,6 +22,9 @@ namespace XML
 class CDataNode : public Node
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = CDATA_NODE;
+
 	//! Default constructor.
 	CDataNode();
 
@@ -32,9 +35,6 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the text string.
 	const tstring& text() const;
 
@@ -54,14 +54,6 @@ private:
 //! The default CDataNode smart-pointer type.
 typedef Core::RefCntPtr<CDataNode> CDataNodePtr;
 
-////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
-
-inline NodeType CDataNode::type() const
-{
-	return CDATA_NODE;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the text string.
 
@@ -76,6 +68,8 @@ inline const tstring& CDataNode::text() const
 inline void CDataNode::setText(const tstring& text_)
 {
 	m_text = text_;
+
+	notifyModified();
 }
 
 //namespace XML
@@ -13,7 +13,8 @@ namespace XML
 //! Default constructor.
 
 CommentNode::CommentNode()
-	: m_comment()
+	: Node(NODE_TYPE)
+	, m_comment()
 {
 }
 
@@ -21,7 +22,8 @@ CommentNode::CommentNode()
 //! Construction from a string comment.
 
 CommentNode::CommentNode(const tstring& comment_)
-	: m_comment(comment_)
+	: Node(NODE_TYPE)
+	, m_comment(comment_)
 {
 }
 
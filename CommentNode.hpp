@@ -22,6 +22,9 @@ namespace XML
 class CommentNode : public Node
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = COMMENT_NODE;
+
 	//! Default constructor.
 	CommentNode();
 
@@ -32,9 +35,6 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the comment.
 	const tstring& comment() const;
 
@@ -54,14 +54,6 @@ private:
 //! The default CommentNode smart-pointer type.
 typedef Core::RefCntPtr<CommentNode> CommentNodePtr;
 
-////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
-
-inline NodeType CommentNode::type() const
-{
-	return COMMENT_NODE;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the comment.
 
@@ -76,6 +68,8 @@ inline const tstring& CommentNode::comment() const
 inline void CommentNode::setComment(const tstring& comment_)
 {
 	m_comment = comment_;
+
+	notifyModified();
 }
 
 //namespace XML
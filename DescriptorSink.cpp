@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DescriptorSink.cpp
+//! \brief  The DescriptorSink class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DescriptorSink.hpp"
+#include "IOException.hpp"
+#include <errno.h>
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a block of bytes to a file descriptor, returning the number written,
+//! or a negative value on error.
+
+static long writeBytes(int fd, const char* bytes, size_t count)
+{
+#ifdef _MSC_VER
+	return ::_write(fd, bytes, static_cast<uint>(count));
+#else
+	return static_cast<long>(::write(fd, bytes, count));
+#endif
+}
+
+#ifndef _MSC_VER
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a sequence of blocks of bytes to a file descriptor with a single gather
+//! write. A partial write is retried from the first byte not written. The blocks
+//! are never empty, so a write that makes no progress is treated as an error.
+
+static void writeVectors(int fd, struct iovec* vectors, size_t count)
+{
+	while (count != 0)
+	{
+		const long written = static_cast<long>(::writev(fd, vectors, static_cast<int>(count)));
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw IOException(TXT("Failed to write the XML to the file descriptor"));
+		}
+
+		if (written == 0)
+			throw IOException(TXT("Failed to write the XML to the file descriptor as nothing was written"));
+
+		size_t remaining = written;
+
+		// Skip the blocks written in full.
+		while ( (count != 0) && (remaining >= vectors->iov_len) )
+		{
+			remaining -= vectors->iov_len;
+			++vectors;
+			--count;
+		}
+
+		if (count != 0)
+		{
+			vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+			vectors->iov_len -= remaining;
+		}
+	}
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from an open file descriptor.
+
+DescriptorSink::DescriptorSink(int fd)
+	: m_fd(fd)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+DescriptorSink::~DescriptorSink()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a chunk of text to the file descriptor. A partial write, such as to a
+//! pipe, is retried until all the text has been written. A write that makes no
+//! progress is treated as an error, rather than retried forever.
+
+void DescriptorSink::write(const tchar* text, size_t length)
+{
+	const char* bytes = reinterpret_cast<const char*>(text);
+	size_t      count = length * sizeof(tchar);
+
+	while (count != 0)
+	{
+		const long written = writeBytes(m_fd, bytes, count);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw IOException(TXT("Failed to write the XML to the file descriptor"));
+		}
+
+		if (written == 0)
+			throw IOException(TXT("Failed to write the XML to the file descriptor as nothing was written"));
+
+		bytes += written;
+		count -= written;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a sequence of chunks of text to the file descriptor. The chunks are
+//! written with writev() in batches, so that the text is not copied into a
+//! single buffer first.
+
+void DescriptorSink::writeChunks(const Chunk* chunks, size_t count)
+{
+#ifdef _MSC_VER
+	OutputSink::writeChunks(chunks, count);
+#else
+	const size_t MAX_VECTORS = 64;
+
+	size_t next = 0;
+
+	while (next != count)
+	{
+		struct iovec vectors[MAX_VECTORS];
+		size_t       used = 0;
+
+		for (; (next != count) && (used != MAX_VECTORS); ++next)
+		{
+			if (chunks[next].m_length == 0)
+				continue;
+
+			vectors[used].iov_base = const_cast<tchar*>(chunks[next].m_text);
+			vectors[used].iov_len = chunks[next].m_length * sizeof(tchar);
+			++used;
+		}
+
+		writeVectors(m_fd, vectors, used);
+	}
+#endif
+}
+
+//namespace XML
+}
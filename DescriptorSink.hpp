@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DescriptorSink.hpp
+//! \brief  The DescriptorSink class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_DESCRIPTORSINK_HPP
+#define XML_DESCRIPTORSINK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "OutputSink.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The sink used to write the output to a file descriptor, such as a file,
+//! pipe or socket, without any further buffering. The characters are written
+//! as is, so a UNICODE build writes UTF-16. The descriptor is not owned by the
+//! sink.
+
+class DescriptorSink : public OutputSink /*, private NotCopyable*/
+{
+public:
+	//! Construction from an open file descriptor.
+	explicit DescriptorSink(int fd);
+
+	//! Destructor.
+	virtual ~DescriptorSink();
+
+	//
+	// Methods.
+	//
+
+	//! Write a chunk of text to the file descriptor.
+	virtual void write(const tchar* text, size_t length); // throw(IOException)
+
+	//! Write a sequence of chunks of text to the file descriptor.
+	virtual void writeChunks(const Chunk* chunks, size_t count); // throw(IOException)
+
+private:
+	//
+	// Members.
+	//
+	int		m_fd;		//!< The file descriptor to write to.
+
+	// NotCopyable.
+	DescriptorSink(const DescriptorSink&);
+	DescriptorSink& operator=(const DescriptorSink);
+};
+
+//namespace XML
+}
+
+#endif // XML_DESCRIPTORSINK_HPP
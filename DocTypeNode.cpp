@@ -13,7 +13,8 @@ namespace XML
 //! Default constructor.
 
 DocTypeNode::DocTypeNode()
-	: m_declaration()
+	: Node(NODE_TYPE)
+	, m_declaration()
 {
 }
 
@@ -21,7 +22,8 @@ DocTypeNode::DocTypeNode()
 //! Construction from a string declaration.
 
 DocTypeNode::DocTypeNode(const tstring& declaration_)
-	: m_declaration(declaration_)
+	: Node(NODE_TYPE)
+	, m_declaration(declaration_)
 {
 }
 
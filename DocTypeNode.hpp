@@ -23,6 +23,9 @@ namespace XML
 class DocTypeNode : public Node
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = DOCTYPE_NODE;
+
 	//! Default constructor.
 	DocTypeNode();
 
@@ -33,9 +36,6 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the declaration.
 	const tstring& declaration() const;
 
@@ -55,14 +55,6 @@ private:
 //! The default DocType smart-pointer type.
 typedef Core::RefCntPtr<DocTypeNode> DocTypeNodePtr;
 
-////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
-
-inline NodeType DocTypeNode::type() const
-{
-	return DOCTYPE_NODE;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the declaration.
 
@@ -77,6 +69,8 @@ inline const tstring& DocTypeNode::declaration() const
 inline void DocTypeNode::setDeclaration(const tstring& declaration_)
 {
 	m_declaration = declaration_;
+
+	notifyModified();
 }
 
 //namespace XML
@@ -5,15 +5,288 @@
 
 #include "Common.hpp"
 #include "Document.hpp"
+#include "TreeWalker.hpp"
+#include <algorithm>
 
 namespace XML
 {
 
+//! The default name of the attribute used to identify elements.
+const tchar* Document::DEFAULT_ID_ATTRIBUTE = TXT("id");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the depth of a node within its tree.
+
+static size_t depthOf(const Node* node)
+{
+	size_t depth = 0;
+
+	for (; node->hasParent(); node = node->parentNode())
+		++depth;
+
+	return depth;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if one node comes before another in document order. Both nodes are
+//! lifted to the same depth and then to a pair of siblings, which are ordered
+//! by walking the sibling list. This is O(depth + breadth), which is only
+//! needed when an index has to order elements not being appended.
+
+static bool precedes(const Node* lhs, const Node* rhs)
+{
+	size_t lhsDepth = depthOf(lhs);
+	size_t rhsDepth = depthOf(rhs);
+
+	// An ancestor comes before its descendants.
+	for (; lhsDepth > rhsDepth; --lhsDepth)
+	{
+		lhs = lhs->parentNode();
+
+		if (lhs == rhs)
+			return false;
+	}
+
+	for (; rhsDepth > lhsDepth; --rhsDepth)
+	{
+		rhs = rhs->parentNode();
+
+		if (rhs == lhs)
+			return true;
+	}
+
+	if (lhs == rhs)
+		return false;
+
+	while (lhs->parentNode() != rhs->parentNode())
+	{
+		lhs = lhs->parentNode();
+		rhs = rhs->parentNode();
+	}
+
+	for (const Node* node = lhs->nextSibling().get(); node != nullptr; node = node->nextSibling().get())
+	{
+		if (node == rhs)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add an element to a list of elements in document order. An element that
+//! comes after the last one, such as when reading, is simply appended.
+
+static void insertInOrder(Document::Elements& elements, ElementNode* element)
+{
+	if ( (elements.empty()) || (precedes(elements.back(), element)) )
+		elements.push_back(element);
+	else
+		elements.insert(std::lower_bound(elements.begin(), elements.end(), element, precedes), element);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element from the list of elements for a key, removing the key
+//! once the list is empty.
+
+static void removeElement(StringMap<Document::Elements>& index, const tstring& key, ElementNode* element)
+{
+	Document::Elements* elements = index.find(key);
+
+	if (elements == nullptr)
+		return;
+
+	Document::Elements::iterator it = std::find(elements->begin(), elements->end(), element);
+
+	if (it == elements->end())
+		return;
+
+	elements->erase(it);
+
+	if (elements->empty())
+		index.erase(key);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit the elements in a subtree. A lone node, such as each one appended
+//! whilst reading, is visited directly rather than by walking it, as only
+//! elements are indexed.
+
+static void visitElements(const Node& subtree, NodeVisitor& visitor)
+{
+	const NodeContainer* container = NodeContainer::fromNode(&subtree);
+
+	if (container == nullptr)
+		return;
+
+	if (container->hasChildren())
+		TreeWalker::walkTree(subtree, visitor);
+	else if (subtree.type() == ELEMENT_NODE)
+		visitor.enterElement(static_cast<const ElementNode&>(subtree));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The visitor used to find the elements with an ID attribute in a subtree.
+
+class IdVisitor : public NodeVisitor
+{
+public:
+	//! The type of callback invoked for each element with an ID.
+	typedef void (Document::*Callback)(ElementNode* element, const tstring& id) const;
+
+	//! Constructor.
+	IdVisitor(const Document& document, const tstring& attribute, Callback callback)
+		: m_document(document)
+		, m_attribute(attribute)
+		, m_callback(callback)
+	{
+	}
+
+	//! Invoke the callback if the element has an ID attribute.
+	virtual Action enterElement(const ElementNode& element)
+	{
+		AttributePtr id = element.getAttributes().find(m_attribute);
+
+		if (id.get() != nullptr)
+			(m_document.*m_callback)(const_cast<ElementNode*>(&element), id->value());
+
+		return CONTINUE;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const Document&	m_document;		//!< The document being indexed.
+	const tstring&	m_attribute;	//!< The name of the ID attribute.
+	Callback		m_callback;		//!< The index method to invoke.
+
+	// NotCopyable.
+	IdVisitor(const IdVisitor&);
+	IdVisitor& operator=(const IdVisitor);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The visitor used to add the elements in a subtree to the name index.
+
+class NameVisitor : public NodeVisitor
+{
+public:
+	//! The type of index being built.
+	typedef StringMap<Document::Elements> Index;
+
+	//! Constructor.
+	NameVisitor(Index& index)
+		: m_index(index)
+	{
+	}
+
+	//! Append the element to the list of elements with the same name.
+	virtual Action enterElement(const ElementNode& element)
+	{
+		m_index[element.name()].push_back(const_cast<ElementNode*>(&element));
+
+		return CONTINUE;
+	}
+
+private:
+	//
+	// Members.
+	//
+	Index&	m_index;	//!< The index being built.
+
+	// NotCopyable.
+	NameVisitor(const NameVisitor&);
+	NameVisitor& operator=(const NameVisitor);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The visitor used to add or remove the elements in a subtree from the
+//! attribute indexes.
+
+class AttributeVisitor : public NodeVisitor
+{
+public:
+	//! The type of index being updated.
+	typedef std::map<tstring, StringMap<Document::Elements> > Index;
+
+	//! How the index is updated.
+	enum Update
+	{
+		APPEND,		//!< Append the elements, which come after all the others.
+		INSERT,		//!< Insert the elements in document order.
+		REMOVE		//!< Remove the elements.
+	};
+
+	//! Constructor.
+	AttributeVisitor(Index& index, Update update)
+		: m_index(index)
+		, m_update(update)
+	{
+	}
+
+	//! Update the list of elements for each indexed attribute.
+	virtual Action enterElement(const ElementNode& element)
+	{
+		const Attributes& attributes = element.getAttributes();
+
+		if (attributes.isEmpty())
+			return CONTINUE;
+
+		ElementNode* node = const_cast<ElementNode*>(&element);
+
+		for (Index::iterator it = m_index.begin(); it != m_index.end(); ++it)
+		{
+			AttributePtr attribute = attributes.find(it->first);
+
+			if (attribute.get() == nullptr)
+				continue;
+
+			if (m_update == APPEND)
+				it->second[attribute->value()].push_back(node);
+			else if (m_update == INSERT)
+				insertInOrder(it->second[attribute->value()], node);
+			else
+				removeElement(it->second, attribute->value(), node);
+		}
+
+		return CONTINUE;
+	}
+
+private:
+	//
+	// Members.
+	//
+	Index&	m_index;	//!< The index being updated.
+	Update	m_update;	//!< How the index is updated.
+
+	// NotCopyable.
+	AttributeVisitor(const AttributeVisitor&);
+	AttributeVisitor& operator=(const AttributeVisitor);
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Default constructor.
 
 Document::Document()
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
+	, m_rootElement(nullptr)
+	, m_rootElementValid(true)
+	, m_idAttribute(DEFAULT_ID_ATTRIBUTE)
+	, m_idIndexEnabled(false)
+	, m_idIndex()
+	, m_idIndexValid(false)
+	, m_nameIndexEnabled(false)
+	, m_nameIndex()
+	, m_nameIndexValid(false)
+	, m_attributeIndex()
+	, m_attributeIndexValid(false)
+	, m_generation(0)
+	, m_queryCacheEnabled(false)
+	, m_queryCache()
+	, m_queryCacheGeneration(0)
+	, m_sourceText()
 {
 }
 
@@ -21,7 +294,24 @@ Document::Document()
 //! Construction with a root element.
 
 Document::Document(ElementNodePtr root)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
+	, m_rootElement(nullptr)
+	, m_rootElementValid(true)
+	, m_idAttribute(DEFAULT_ID_ATTRIBUTE)
+	, m_idIndexEnabled(false)
+	, m_idIndex()
+	, m_idIndexValid(false)
+	, m_nameIndexEnabled(false)
+	, m_nameIndex()
+	, m_nameIndexValid(false)
+	, m_attributeIndex()
+	, m_attributeIndexValid(false)
+	, m_generation(0)
+	, m_queryCacheEnabled(false)
+	, m_queryCache()
+	, m_queryCacheGeneration(0)
+	, m_sourceText()
 {
 	appendChild(root);
 }
@@ -34,54 +324,435 @@ Document::~Document()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Checks if the document has a root element.
+//! Get the root element.
+
+const ElementNodePtr Document::getRootElement() const
+{
+	return ElementNodePtr(const_cast<ElementNode*>(rootElement()), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the root element.
 
-bool Document::hasRootElement() const
+ElementNodePtr Document::getRootElement()
 {
-	// Find the first element node...
-	for (Nodes::const_iterator it = beginChild(); it != endChild(); ++it)
+	return ElementNodePtr(rootElement(), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Index the elements by the value of their ID attribute. Once enabled the
+//! index is maintained as elements are appended, removed and have their
+//! attributes set. Any existing elements are indexed on the next lookup.
+
+void Document::enableIdIndex(const tstring& attribute)
+{
+	if ( (m_idIndexEnabled) && (attribute == m_idAttribute) )
+		return;
+
+	m_idAttribute = attribute;
+	m_idIndexEnabled = true;
+	m_idIndex.clear();
+	m_idIndexValid = !hasChildren();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find an element by the value of its ID attribute. If the index hasn't been
+//! enabled it's built on first use with the default ID attribute name. When
+//! IDs are duplicated the first element in document order is returned, which
+//! is found by comparing the duplicates.
+
+ElementNodePtr Document::getElementById(const tstring& id) const
+{
+	if (!m_idIndexEnabled)
+		const_cast<Document*>(this)->enableIdIndex();
+
+	if (!m_idIndexValid)
+		buildIdIndex();
+
+	const Elements* elements = m_idIndex.find(id);
+
+	if (elements == nullptr)
+		return ElementNodePtr();
+
+	ElementNode* first = elements->front();
+
+	for (Elements::const_iterator it = elements->begin()+1; it != elements->end(); ++it)
 	{
-		const NodePtr& node = *it;
+		if (precedes(*it, first))
+			first = *it;
+	}
 
-		if (node->type() == ELEMENT_NODE)
-			return true;
+	return ElementNodePtr(first, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Index the elements by their name. Once enabled the index is maintained as
+//! elements are appended to the end of the document, which is how a document
+//! is built when reading. Any other change means the index is rebuilt on the
+//! next lookup.
+
+void Document::enableNameIndex()
+{
+	if (m_nameIndexEnabled)
+		return;
+
+	m_nameIndexEnabled = true;
+	m_nameIndex.clear();
+	m_nameIndexValid = !hasChildren();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find all the elements with the given name, in document order. If the index
+//! hasn't been enabled it's built on first use. The list is only valid until
+//! the document is next modified.
+
+const Document::Elements& Document::elementsByName(const tstring& name_) const
+{
+	static const Elements none;
+
+	if (!m_nameIndexEnabled)
+		const_cast<Document*>(this)->enableNameIndex();
+
+	if (!m_nameIndexValid)
+		buildNameIndex();
+
+	const Elements* elements = m_nameIndex.find(name_);
+
+	if (elements == nullptr)
+		return none;
+
+	return *elements;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Index the elements by the value of an attribute. Once enabled the index is
+//! maintained as elements are linked in, unlinked and have their attributes
+//! set. Any existing elements are indexed on the next lookup.
+
+void Document::enableAttributeIndex(const tstring& attribute)
+{
+	if (hasAttributeIndex(attribute))
+		return;
+
+	m_attributeIndex[attribute];
+	m_attributeIndexValid = !hasChildren();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find all the elements with the given attribute value, in document order.
+//! If the attribute hasn't been indexed it's indexed on first use. The list is
+//! only valid until the document is next modified.
+
+const Document::Elements& Document::elementsByAttribute(const tstring& attribute, const tstring& value) const
+{
+	static const Elements none;
+
+	if (!hasAttributeIndex(attribute))
+		const_cast<Document*>(this)->enableAttributeIndex(attribute);
+
+	if (!m_attributeIndexValid)
+		buildAttributeIndex();
+
+	const ValueIndex& values = m_attributeIndex.find(attribute)->second;
+
+	const Elements* elements = values.find(value);
+
+	if (elements == nullptr)
+		return none;
+
+	return *elements;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Cache the results of XPath queries. The results are keyed by the query and
+//! the context node, and are all discarded on the first lookup after the
+//! document has been modified. The cache isn't bounded, so it suits a
+//! document that is queried far more often than it's changed.
+
+void Document::enableQueryCache()
+{
+	m_queryCacheEnabled = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the cached results of an XPath query, appending them to the results.
+//! Returns false if the query hasn't been cached since the document was last
+//! modified.
+
+bool Document::findQueryResults(const tstring& query, const Node* context, Nodes& results) const
+{
+	if (!m_queryCacheEnabled)
+		return false;
+
+	validateQueryCache();
+
+	QueryCache::const_iterator it = m_queryCache.find(QueryKey(query, context));
+
+	if (it == m_queryCache.end())
+		return false;
+
+	const QueryResults& cached = it->second;
+
+	results.reserve(results.size() + cached.size());
+
+	for (QueryResults::const_iterator node = cached.begin(); node != cached.end(); ++node)
+		results.push_back(NodePtr(const_cast<Node*>(*node), true));
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Cache the results of an XPath query. The nodes are held without taking a
+//! reference, as they belong to the document.
+
+void Document::cacheQueryResults(const tstring& query, const Node* context, const Nodes& results) const
+{
+	if (!m_queryCacheEnabled)
+		return;
+
+	validateQueryCache();
+
+	QueryResults& cached = m_queryCache[QueryKey(query, context)];
+
+	cached.clear();
+	cached.reserve(results.size());
+
+	for (Nodes::const_iterator node = results.begin(); node != results.end(); ++node)
+		cached.push_back(node->get());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the cached root element after a child has been linked in.
+
+void Document::onChildLinked(Node* child, bool appended)
+{
+	if ( (child->type() != ELEMENT_NODE) || (!m_rootElementValid) )
+		return;
+
+	// First element?
+	if (m_rootElement == nullptr)
+		m_rootElement = static_cast<ElementNode*>(child);
+	// Possibly inserted before the current root?
+	else if (!appended)
+		m_rootElementValid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the cached root element after a child has been unlinked.
+
+void Document::onChildUnlinked(Node* child)
+{
+	if (child == m_rootElement)
+	{
+		m_rootElement = nullptr;
+		m_rootElementValid = false;
 	}
+}
 
-	return false;
+////////////////////////////////////////////////////////////////////////////////
+//! Update the indexes after a subtree has been linked into the document. The
+//! subtree is last if nothing follows it in document order.
+
+void Document::onSubtreeLinked(Node* subtree, bool last)
+{
+	onNodeModified();
+
+	if ( (m_nameIndexEnabled) && (m_nameIndexValid) )
+	{
+		if (last)
+		{
+			NameVisitor visitor(m_nameIndex);
+
+			visitElements(*subtree, visitor);
+		}
+		else
+		{
+			m_nameIndexValid = false;
+		}
+	}
+
+	if ( (!m_attributeIndex.empty()) && (m_attributeIndexValid) )
+	{
+		AttributeVisitor visitor(m_attributeIndex, last ? AttributeVisitor::APPEND : AttributeVisitor::INSERT);
+
+		visitElements(*subtree, visitor);
+	}
+
+	if ( (m_idIndexEnabled) && (m_idIndexValid) )
+	{
+		IdVisitor visitor(*this, m_idAttribute, &Document::indexId);
+
+		visitElements(*subtree, visitor);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the root element.
+//! Update the indexes after a subtree has been unlinked from the document.
 
-const ElementNodePtr Document::getRootElement() const
+void Document::onSubtreeUnlinked(Node* subtree)
 {
-	// Find the first element node...
-	for (Nodes::const_iterator it = beginChild(); it != endChild(); ++it)
+	onNodeModified();
+
+	m_nameIndexValid = false;
+
+	if ( (!m_attributeIndex.empty()) && (m_attributeIndexValid) )
 	{
-		NodePtr node = *it;
+		AttributeVisitor visitor(m_attributeIndex, AttributeVisitor::REMOVE);
 
-		if (node->type() == ELEMENT_NODE)
-			return Core::static_ptr_cast<ElementNode>(node);
+		visitElements(*subtree, visitor);
 	}
 
-	return ElementNodePtr();
+	if ( (m_idIndexEnabled) && (m_idIndexValid) )
+	{
+		IdVisitor visitor(*this, m_idAttribute, &Document::unindexId);
+
+		visitElements(*subtree, visitor);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the root element.
+//! Update the indexes after an elements attribute has been set or removed. The
+//! old value is null if the attribute has been added and the new value is null
+//! if it has been removed. The element has already noted the modification
+//! itself.
 
-ElementNodePtr Document::getRootElement()
+void Document::onAttributeChanged(ElementNode* element, const tstring& name, const tstring* oldValue, const tstring* newValue)
+{
+	if (m_attributeIndexValid)
+	{
+		AttributeIndex::iterator it = m_attributeIndex.find(name);
+
+		if (it != m_attributeIndex.end())
+		{
+			if (oldValue != nullptr)
+				removeElement(it->second, *oldValue, element);
+
+			if (newValue != nullptr)
+				insertInOrder(it->second[*newValue], element);
+		}
+	}
+
+	if ( (m_idIndexEnabled) && (m_idIndexValid) && (name == m_idAttribute) )
+	{
+		if (oldValue != nullptr)
+			unindexId(element, *oldValue);
+
+		if (newValue != nullptr)
+			indexId(element, *newValue);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the indexes after an element has been renamed. The element's position
+//! within the list for its new name isn't known, so the name index is rebuilt
+//! on the next lookup.
+
+void Document::onElementRenamed(ElementNode* /*element*/)
+{
+	m_nameIndexValid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Note that a node in the document has been modified.
+
+void Document::onNodeModified()
+{
+	++m_generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the cached query results if the document has been modified since
+//! they were cached.
+
+void Document::validateQueryCache() const
+{
+	if (m_queryCacheGeneration == m_generation)
+		return;
+
+	m_queryCache.clear();
+	m_queryCacheGeneration = m_generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the root element and cache it.
+
+void Document::findRootElement() const
 {
+	m_rootElement = nullptr;
+
 	// Find the first element node...
-	for (Nodes::const_iterator it = beginChild(); it != endChild(); ++it)
+	for (const_iterator it = beginChild(); it != endChild(); ++it)
 	{
-		NodePtr node = *it;
+		const NodePtr& node = *it;
 
 		if (node->type() == ELEMENT_NODE)
-			return Core::static_ptr_cast<ElementNode>(node);
+		{
+			m_rootElement = static_cast<ElementNode*>(node.get());
+			break;
+		}
 	}
 
-	return ElementNodePtr();
+	m_rootElementValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the index of elements by ID.
+
+void Document::buildIdIndex() const
+{
+	m_idIndex.clear();
+
+	IdVisitor visitor(*this, m_idAttribute, &Document::indexId);
+
+	TreeWalker::walkTree(*this, visitor);
+
+	m_idIndexValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the index of elements by name.
+
+void Document::buildNameIndex() const
+{
+	m_nameIndex.clear();
+
+	NameVisitor visitor(m_nameIndex);
+
+	TreeWalker::walkTree(*this, visitor);
+
+	m_nameIndexValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the indexes of elements by attribute value.
+
+void Document::buildAttributeIndex() const
+{
+	for (AttributeIndex::iterator it = m_attributeIndex.begin(); it != m_attributeIndex.end(); ++it)
+		it->second.clear();
+
+	AttributeVisitor visitor(m_attributeIndex, AttributeVisitor::APPEND);
+
+	TreeWalker::walkTree(*this, visitor);
+
+	m_attributeIndexValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add an element to the ID index. Every element with an ID is indexed, as a
+//! duplicate must be found again if the first element with the ID is removed.
+
+void Document::indexId(ElementNode* element, const tstring& id) const
+{
+	m_idIndex[id].push_back(element);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element from the ID index.
+
+void Document::unindexId(ElementNode* element, const tstring& id) const
+{
+	removeElement(m_idIndex, id, element);
 }
 
 //namespace XML
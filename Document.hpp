@@ -14,6 +14,8 @@
 #include "Node.hpp"
 #include "NodeContainer.hpp"
 #include "ElementNode.hpp"
+#include "StringMap.hpp"
+#include <map>
 
 namespace XML
 {
@@ -24,6 +26,15 @@ namespace XML
 class Document : public Node, public NodeContainer
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = DOCUMENT_NODE;
+
+	//! The default name of the attribute used to identify elements.
+	static const tchar* DEFAULT_ID_ATTRIBUTE;
+
+	//! The container type used for a list of elements in document order.
+	typedef std::vector<ElementNode*> Elements;
+
 	//! Default constructor.
 	Document();
 
@@ -34,12 +45,39 @@ public:
 	// Properties.
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Checks if the document has a root element.
 	bool hasRootElement() const;
 
+	//! Get the root element without taking a reference to it.
+	const ElementNode* rootElement() const;
+
+	//! Get the root element without taking a reference to it.
+	ElementNode* rootElement();
+
+	//! Query if the elements are indexed by their ID attribute.
+	bool hasIdIndex() const;
+
+	//! Get the name of the attribute used to identify elements.
+	const tstring& idAttribute() const;
+
+	//! Query if the elements are indexed by their name.
+	bool hasNameIndex() const;
+
+	//! Query if the elements are indexed by the value of an attribute.
+	bool hasAttributeIndex(const tstring& attribute) const;
+
+	//! Get the number of times the document has been modified.
+	size_t generation() const;
+
+	//! Query if the results of XPath queries are cached.
+	bool hasQueryCache() const;
+
+	//! Query if the source text the document was read from has been kept.
+	bool hasSourceText() const;
+
+	//! Get the source text the document was read from, if kept.
+	const tstring& sourceText() const;
+
 	//
 	// Methods.
 	//
@@ -50,24 +88,238 @@ public:
 	//! Get the root element.
 	ElementNodePtr getRootElement();
 
+	//! Index the elements by the value of their ID attribute.
+	void enableIdIndex(const tstring& attribute = DEFAULT_ID_ATTRIBUTE);
+
+	//! Find an element by the value of its ID attribute.
+	ElementNodePtr getElementById(const tstring& id) const;
+
+	//! Index the elements by their name.
+	void enableNameIndex();
+
+	//! Find all the elements with the given name.
+	const Elements& elementsByName(const tstring& name) const;
+
+	//! Index the elements by the value of an attribute.
+	void enableAttributeIndex(const tstring& attribute);
+
+	//! Find all the elements with the given attribute value.
+	const Elements& elementsByAttribute(const tstring& attribute, const tstring& value) const;
+
+	//! Cache the results of XPath queries.
+	void enableQueryCache();
+
+	//! Find the cached results of an XPath query.
+	bool findQueryResults(const tstring& query, const Node* context, Nodes& results) const;
+
+	//! Cache the results of an XPath query.
+	void cacheQueryResults(const tstring& query, const Node* context, const Nodes& results) const;
+
 private:
+	//! The index of elements by ID attribute value, including any duplicates.
+	typedef StringMap<Elements> IdIndex;
+	//! The index of elements by name.
+	typedef StringMap<Elements> NameIndex;
+	//! The index of elements by the value of a single attribute.
+	typedef StringMap<Elements> ValueIndex;
+	//! The indexes of elements by attribute value.
+	typedef std::map<tstring, ValueIndex> AttributeIndex;
+	//! The cached results of a query, held without a reference.
+	typedef std::vector<const Node*> QueryResults;
+	//! The key for a cached query, which is the query and its context node.
+	typedef std::pair<tstring, const Node*> QueryKey;
+	//! The cached results by query and context node.
+	typedef std::map<QueryKey, QueryResults> QueryCache;
+
 	//
 	// Members.
 	//
+	mutable ElementNode*	m_rootElement;		//!< The cached root element.
+	mutable bool			m_rootElementValid;	//!< Is the cached root element up-to-date?
+	mutable tstring			m_idAttribute;		//!< The name of the ID attribute.
+	mutable bool			m_idIndexEnabled;	//!< Are the elements indexed by ID?
+	mutable IdIndex			m_idIndex;			//!< The elements by ID attribute value.
+	mutable bool			m_idIndexValid;		//!< Is the ID index up-to-date?
+	bool					m_nameIndexEnabled;	//!< Are the elements indexed by name?
+	mutable NameIndex		m_nameIndex;		//!< The elements by name.
+	mutable bool			m_nameIndexValid;	//!< Is the name index up-to-date?
+	mutable AttributeIndex	m_attributeIndex;	//!< The elements by attribute value.
+	mutable bool			m_attributeIndexValid;	//!< Is the attribute index up-to-date?
+	size_t					m_generation;		//!< The number of modifications.
+	bool					m_queryCacheEnabled;	//!< Are query results cached?
+	mutable QueryCache		m_queryCache;		//!< The cached query results.
+	mutable size_t			m_queryCacheGeneration;	//!< The generation the cache is for.
+	tstring					m_sourceText;		//!< The source text, if kept.
 
 	//! Destructor.
 	virtual ~Document();
+
+	//
+	// Internal methods.
+	//
+
+	//! Update the cached root element after a child has been linked in.
+	void onChildLinked(Node* child, bool appended);
+
+	//! Update the cached root element after a child has been unlinked.
+	void onChildUnlinked(Node* child);
+
+	//! Update the indexes after a subtree has been linked into the document.
+	void onSubtreeLinked(Node* subtree, bool last);
+
+	//! Update the indexes after a subtree has been unlinked from the document.
+	void onSubtreeUnlinked(Node* subtree);
+
+	//! Update the indexes after an elements attribute has been set or removed.
+	void onAttributeChanged(ElementNode* element, const tstring& name, const tstring* oldValue, const tstring* newValue);
+
+	//! Update the indexes after an element has been renamed.
+	void onElementRenamed(ElementNode* element);
+
+	//! Note that a node in the document has been modified.
+	void onNodeModified();
+
+	//! Discard the cached query results if the document has since changed.
+	void validateQueryCache() const;
+
+	//! Find the root element and cache it.
+	void findRootElement() const;
+
+	//! Build the index of elements by ID.
+	void buildIdIndex() const;
+
+	//! Add an element to the ID index.
+	void indexId(ElementNode* element, const tstring& id) const;
+
+	//! Remove an element from the ID index.
+	void unindexId(ElementNode* element, const tstring& id) const;
+
+	//! Build the index of elements by name.
+	void buildNameIndex() const;
+
+	//! Build the indexes of elements by attribute value.
+	void buildAttributeIndex() const;
+
+	//
+	// Friends.
+	//
+
+	//! Allow container class to notify us of changes to the children.
+	friend class NodeContainer;
+
+	//! Allow element class to notify us of changes to the name and attributes.
+	friend class ElementNode;
+
+	//! Allow the nodes to notify us of changes to their values.
+	friend class Node;
+
+	//! Allow the attributes to notify us of changes to an elements attributes.
+	friend class Attributes;
+
+	//! Allow the reader to keep the source text.
+	friend class Reader;
 };
 
 //! The default Document smart-pointer type.
 typedef Core::RefCntPtr<Document> DocumentPtr;
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
+//! Checks if the document has a root element.
+
+inline bool Document::hasRootElement() const
+{
+	return (rootElement() != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the root element without taking a reference to it. The root element is
+//! tracked as the children are changed and so this is normally O(1).
+
+inline const ElementNode* Document::rootElement() const
+{
+	if (!m_rootElementValid)
+		findRootElement();
+
+	return m_rootElement;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the root element without taking a reference to it. The root element is
+//! tracked as the children are changed and so this is normally O(1).
+
+inline ElementNode* Document::rootElement()
+{
+	if (!m_rootElementValid)
+		findRootElement();
+
+	return m_rootElement;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the elements are indexed by their ID attribute.
+
+inline bool Document::hasIdIndex() const
+{
+	return m_idIndexEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the attribute used to identify elements.
+
+inline const tstring& Document::idAttribute() const
+{
+	return m_idAttribute;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the elements are indexed by their name.
+
+inline bool Document::hasNameIndex() const
+{
+	return m_nameIndexEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the elements are indexed by the value of an attribute.
+
+inline bool Document::hasAttributeIndex(const tstring& attribute) const
+{
+	return (m_attributeIndex.find(attribute) != m_attributeIndex.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of times the document has been modified. This changes
+//! whenever a node is linked in or unlinked, or a node's name, value or
+//! attributes are set.
+
+inline size_t Document::generation() const
+{
+	return m_generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the results of XPath queries are cached.
+
+inline bool Document::hasQueryCache() const
+{
+	return m_queryCacheEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the source text the document was read from has been kept.
+
+inline bool Document::hasSourceText() const
+{
+	return !m_sourceText.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the source text the document was read from, if kept. The unmodified
+//! nodes record their span of this text.
 
-inline NodeType Document::type() const
+inline const tstring& Document::sourceText() const
 {
-	return DOCUMENT_NODE;
+	return m_sourceText;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -6,6 +6,7 @@
 #include "Common.hpp"
 #include "ElementNode.hpp"
 #include "TextNode.hpp"
+#include "Document.hpp"
 
 namespace XML
 {
@@ -14,49 +15,66 @@ namespace XML
 //! Default constructor.
 
 ElementNode::ElementNode()
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name()
 	, m_attributes()
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from the element name.
 
 ElementNode::ElementNode(const tstring& name_)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name(name_)
 	, m_attributes()
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from an element name and single attribute.
 
 ElementNode::ElementNode(const tstring& name_, AttributePtr attribute)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name(name_)
 	, m_attributes(attribute)
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from an element name and attributes.
 
 ElementNode::ElementNode(const tstring& name_, const Attributes& attributes)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name(name_)
 	, m_attributes(attributes)
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from an element name and a range of child nodes.
 
 ElementNode::ElementNode(const tstring& name_, NodePtr* begin, NodePtr* end)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name(name_)
+	, m_attributes()
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
+
 	for (NodePtr* it = begin; it != end; ++it)
 		appendChild(*it);
 }
@@ -68,6 +86,31 @@ ElementNode::~ElementNode()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Set the elements name. The owning document, if any, is notified so that it
+//! can keep its name index up-to-date.
+
+void ElementNode::setName(const tstring& name_)
+{
+	m_name = name_;
+
+	notifyModified();
+
+	Document* document = ownerDocument();
+
+	if (document != nullptr)
+		document->onElementRenamed(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set an attribute from a name/value pair. The attributes notify the owning
+//! document, if any, so that it can keep its indexes up-to-date.
+
+void ElementNode::setAttribute(const tstring& name_, const tstring& value)
+{
+	m_attributes.set(name_, value);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the child text node value if it exists.
 
@@ -79,12 +122,12 @@ tstring ElementNode::getTextValue() const
 	if (getChildCount() != 1)
 		throw Core::BadLogicException(TXT("Can't retrieve text value when more than 1 child node exists"));
 
-	NodePtr child = getChild(0);
+	const NodePtr& child = firstChild();
 
 	if (child->type() != TEXT_NODE)
 		throw Core::BadLogicException(TXT("Can't retrieve text value when child not a text node"));
 
-	return Core::dynamic_ptr_cast<TextNode>(child)->text();
+	return static_cast<const TextNode*>(child.get())->text();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -94,10 +137,13 @@ Core::RefCntPtr<ElementNode> ElementNode::findFirstElement(const tstring& name_)
 {
 	for (const_iterator it = beginChild(); it != endChild(); ++it)
 	{
-		ElementNodePtr element = Core::dynamic_ptr_cast<ElementNode>(*it);
+		const NodePtr& node = *it;
 
-		if ( (!element.empty()) && (element->name() == name_) )
-			return element;
+		if ( (node->type() == ELEMENT_NODE)
+		  && (static_cast<const ElementNode*>(node.get())->name() == name_) )
+		{
+			return Core::static_ptr_cast<ElementNode>(node);
+		}
 	}
 
 	return ElementNodePtr();
@@ -25,6 +25,9 @@ namespace XML
 class ElementNode : public Node, public NodeContainer
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = ELEMENT_NODE;
+
 	//! Default constructor.
 	ElementNode();
 
@@ -48,15 +51,18 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the elements name.
 	const tstring& name() const;
 
 	//! Set the elements name.
 	void setName(const tstring& name);
 
+	//! Query if the start tag is unmodified since it was read from the source.
+	bool hasStartTagSource() const;
+
+	//! Get the offset of the end of the start tag in the document source.
+	size_t startTagSourceEnd() const;
+
 	//! Get the attributes.
 	const Attributes& getAttributes() const;
 
@@ -85,9 +91,20 @@ private:
 	//
 	tstring		m_name;			//!< The element name.
 	Attributes	m_attributes;	//!< The attributes.
+	size_t		m_startTagEnd;	//!< The end of the start tag in the source, or zero if none.
 
 	//! Destructor.
 	virtual ~ElementNode();
+
+	//
+	// Friends.
+	//
+
+	//! Allow the node to drop the start tag source span when modified.
+	friend class Node;
+
+	//! Allow the reader to set the start tag source span.
+	friend class Reader;
 };
 
 //! The default ElementNode smart-pointer type.
@@ -98,35 +115,43 @@ typedef Core::RefCntPtr<ElementNode> ElementNodePtr;
 
 template<typename T>
 inline ElementNode::ElementNode(const tstring& name_, Core::RefCntPtr<T> childNode)
-	: NodeContainer(this)
+	: Node(NODE_TYPE)
+	, NodeContainer(this)
 	, m_name(name_)
 	, m_attributes()
+	, m_startTagEnd(0)
 {
+	m_attributes.setOwner(this);
+
 	appendChild(childNode);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
+//! Get the elements name.
 
-inline NodeType ElementNode::type() const
+inline const tstring& ElementNode::name() const
 {
-	return ELEMENT_NODE;
+	return m_name;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the elements name.
+//! Query if the start tag is unmodified since it was read from the source. The
+//! start tag is unaffected by changes to the children.
 
-inline const tstring& ElementNode::name() const
+inline bool ElementNode::hasStartTagSource() const
 {
-	return m_name;
+	return (m_startTagEnd != 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Set the elements name.
+//! Get the offset of the end of the start tag in the document source. The
+//! start tag begins at the same offset as the element.
 
-inline void ElementNode::setName(const tstring& name_)
+inline size_t ElementNode::startTagSourceEnd() const
 {
-	m_name = name_;
+	ASSERT(hasStartTagSource());
+
+	return m_startTagEnd;
 }
 
 
@@ -149,12 +174,6 @@ inline Attributes& ElementNode::getAttributes()
 ////////////////////////////////////////////////////////////////////////////////
 //! Set an attribute from a name/value pair.
 
-inline void ElementNode::setAttribute(const tstring& name_, const tstring& value)
-{
-	return m_attributes.set(name_, value);
-}
-
-////////////////////////////////////////////////////////////////////////////////
 //! Get the value of an attribute by name or throw if not found.
 
 inline const tstring& ElementNode::getAttributeValue(const tstring& name_) const
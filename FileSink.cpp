@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FileSink.cpp
+//! \brief  The FileSink class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "FileSink.hpp"
+#include "IOException.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from an open stream.
+
+FileSink::FileSink(FILE* file)
+	: m_file(file)
+{
+	ASSERT(file != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+FileSink::~FileSink()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a chunk of text to the stream.
+
+void FileSink::write(const tchar* text, size_t length)
+{
+	if (fwrite(text, sizeof(tchar), length, m_file) != length)
+		throw IOException(TXT("Failed to write the XML to the file stream"));
+}
+
+//namespace XML
+}
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FileSink.hpp
+//! \brief  The FileSink class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_FILESINK_HPP
+#define XML_FILESINK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "OutputSink.hpp"
+#include <stdio.h>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The sink used to write the output to a C stdio stream. The characters are
+//! written as is, so a UNICODE build writes UTF-16. The stream is not owned by
+//! the sink and is not flushed.
+
+class FileSink : public OutputSink /*, private NotCopyable*/
+{
+public:
+	//! Construction from an open stream.
+	explicit FileSink(FILE* file);
+
+	//! Destructor.
+	virtual ~FileSink();
+
+	//
+	// Methods.
+	//
+
+	//! Write a chunk of text to the stream.
+	virtual void write(const tchar* text, size_t length); // throw(IOException)
+
+private:
+	//
+	// Members.
+	//
+	FILE*	m_file;		//!< The stream to write to.
+
+	// NotCopyable.
+	FileSink(const FileSink&);
+	FileSink& operator=(const FileSink);
+};
+
+//namespace XML
+}
+
+#endif // XML_FILESINK_HPP
@@ -5,6 +5,8 @@
 
 #include "Common.hpp"
 #include "Node.hpp"
+#include "Document.hpp"
+#include "ElementNode.hpp"
 #include <Core/InvalidArgException.hpp>
 #include <Core/StringUtils.hpp>
 
@@ -12,10 +14,15 @@ namespace XML
 {
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Default constructor.
+//! Construction from the concrete node type.
 
-Node::Node()
-	: m_parent(nullptr)
+Node::Node(NodeType type_)
+	: m_type(type_)
+	, m_parent(nullptr)
+	, m_prevSibling(nullptr)
+	, m_nextSibling()
+	, m_sourceBegin(0)
+	, m_sourceEnd(0)
 {
 }
 
@@ -26,6 +33,70 @@ Node::~Node()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Get the document the node belongs to, if any. This is found by walking up
+//! the tree and so is O(depth). A document belongs to itself.
+
+const Document* Node::ownerDocument() const
+{
+	const Node* node = this;
+
+	while (node->m_parent != nullptr)
+		node = node->m_parent;
+
+	if (node->type() != DOCUMENT_NODE)
+		return nullptr;
+
+	return static_cast<const Document*>(node);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the document the node belongs to, if any.
+
+Document* Node::ownerDocument()
+{
+	return const_cast<Document*>(static_cast<const Node*>(this)->ownerDocument());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Notify the owning document, if any, that the node has been modified. Any
+//! source span for the node, including an element's start tag, is dropped.
+
+void Node::notifyModified()
+{
+	clearSource();
+
+	if (m_parent != nullptr)
+		m_parent->invalidateSource();
+
+	Document* document = ownerDocument();
+
+	if (document != nullptr)
+		document->onNodeModified();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drop the source spans of the node, including an element's start tag.
+
+void Node::clearSource()
+{
+	m_sourceEnd = 0;
+
+	if (m_type == ELEMENT_NODE)
+		static_cast<ElementNode*>(this)->m_startTagEnd = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drop the source span of the node and its ancestors, as their source now
+//! differs from the node. An ancestor without a span is only ever below other
+//! ancestors without one, so the walk stops at the first.
+
+void Node::invalidateSource()
+{
+	for (Node* node = this; (node != nullptr) && (node->m_sourceEnd != 0); node = node->m_parent)
+		node->m_sourceEnd = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Convert the node type to a string.
 
@@ -13,12 +13,14 @@
 
 #include "Types.hpp"
 #include <Core/RefCntPtr.hpp>
+#include <Core/BadLogicException.hpp>
 
 namespace XML
 {
 
 // Forward declarations.
 class Node;
+class Document;
 
 //! The default Node smart-pointer type.
 typedef Core::RefCntPtr<Node> NodePtr;
@@ -27,7 +29,14 @@ typedef Core::RefCntPtr<Node> NodePtr;
 //! The base class for all nodes that are stored in an XML document.
 //! The node types use internal reference counting to make it more efficient and
 //! easier to deal with the back pointers. We store the parent node as a raw
-//! pointer to ensure we don't have any cyclic references.
+//! pointer to ensure we don't have any cyclic references. The siblings form an
+//! intrusive list where each node owns the link to the next sibling and holds
+//! a raw pointer back to the previous one.
+//!
+//! A node read from a document that keeps its source also records the span of
+//! source text it was read from. The span is dropped when the node, or any of
+//! its descendants, is modified, so that an unmodified node can be written by
+//! copying its source.
 
 class Node : public Core::RefCounted
 {
@@ -37,7 +46,7 @@ public:
 	//
 
 	//! Get the real type of the node.
-	virtual NodeType type() const = 0;
+	NodeType type() const;
 
 	//! Get the type of the node as a string.
 	const tchar* typeStr() const;
@@ -51,6 +60,46 @@ public:
 	//! Get the parent node.
 	NodePtr parent();
 
+	//! Get the parent node without taking a reference to it.
+	const Node* parentNode() const;
+
+	//! Get the previous sibling node.
+	NodePtr previousSibling() const;
+
+	//! Get the next sibling node.
+	const NodePtr& nextSibling() const;
+
+	//! Get the document the node belongs to, if any.
+	const Document* ownerDocument() const;
+
+	//! Get the document the node belongs to, if any.
+	Document* ownerDocument();
+
+	//! Query if the node is unmodified since it was read from the source.
+	bool hasSource() const;
+
+	//! Get the offset of the node in the document source.
+	size_t sourceBegin() const;
+
+	//! Get the offset of the end of the node in the document source.
+	size_t sourceEnd() const;
+
+	//
+	// Methods.
+	//
+
+	//! Query if the node is of the concrete node type.
+	template<typename T>
+	bool is() const;
+
+	//! Downcast the node to its concrete node type or throw if not that type.
+	template<typename T>
+	const T* as() const; // throw(BadLogicException)
+
+	//! Downcast the node to its concrete node type or throw if not that type.
+	template<typename T>
+	T* as(); // throw(BadLogicException)
+
 	//
 	// Class Methods.
 	//
@@ -59,8 +108,8 @@ public:
 	static const tchar* formatNodeType(NodeType type);
 
 protected:
-	//! Default constructor.
-	Node();
+	//! Construction from the concrete node type.
+	Node(NodeType type);
 
 	//! Destructor.
 	virtual ~Node();
@@ -72,11 +121,36 @@ protected:
 	//! Set the parent node.
 	void setParent(Node* parent);
 
+	//
+	// Internal methods.
+	//
+
+	//! Notify the owning document that the node has been modified.
+	void notifyModified();
+
 private:
 	//
 	// Members.
 	//
-	Node*	m_parent;		//!< The parent node.
+	NodeType	m_type;			//!< The concrete node type.
+	Node*		m_parent;		//!< The parent node.
+	Node*		m_prevSibling;	//!< The previous sibling node.
+	NodePtr		m_nextSibling;	//!< The next sibling node.
+	size_t		m_sourceBegin;	//!< The offset of the node in the document source.
+	size_t		m_sourceEnd;	//!< The end of the node in the source, or zero if none.
+
+	//
+	// Internal methods.
+	//
+
+	//! Set the span of the document source the node was read from.
+	void setSource(size_t begin, size_t end);
+
+	//! Drop the source spans of the node.
+	void clearSource();
+
+	//! Drop the source span of the node and its ancestors.
+	void invalidateSource();
 
 	//
 	// Friends.
@@ -85,11 +159,26 @@ private:
 	//! Allow container class to set the parent.
 	friend class NodeContainer;
 
+	//! Allow the attributes to notify the document of changes.
+	friend class Attributes;
+
+	//! Allow the reader to set the source span.
+	friend class Reader;
+
 	// NotCopyable.
 	Node(const Node&);
 	Node& operator=(const Node&);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//! Get the real type of the node. The type is stored in the base class so
+//! that it can be queried without a virtual call.
+
+inline NodeType Node::type() const
+{
+	return m_type;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the type of the node as a string.
 
@@ -122,6 +211,95 @@ inline NodePtr Node::parent()
 	return NodePtr(m_parent, true);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Get the parent node without taking a reference to it. This leaves the
+//! reference count alone, so that a tree can be walked upwards by more than one
+//! thread at a time.
+
+inline const Node* Node::parentNode() const
+{
+	return m_parent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the previous sibling node.
+
+inline NodePtr Node::previousSibling() const
+{
+	return NodePtr(m_prevSibling, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the next sibling node. The link to the next sibling is owned by this
+//! node and so a reference can be returned without touching the ref-count.
+
+inline const NodePtr& Node::nextSibling() const
+{
+	return m_nextSibling;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the node is unmodified since it was read from the source.
+
+inline bool Node::hasSource() const
+{
+	return (m_sourceEnd != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the offset of the node in the document source. This is also kept for
+//! an element whose start tag is unmodified.
+
+inline size_t Node::sourceBegin() const
+{
+	return m_sourceBegin;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the offset of the end of the node in the document source.
+
+inline size_t Node::sourceEnd() const
+{
+	ASSERT(hasSource());
+
+	return m_sourceEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the node is of the concrete node type.
+
+template<typename T>
+inline bool Node::is() const
+{
+	return (m_type == T::NODE_TYPE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Downcast the node to its concrete node type or throw if not that type. The
+//! check uses the stored node type rather than RTTI.
+
+template<typename T>
+inline const T* Node::as() const
+{
+	if (m_type != T::NODE_TYPE)
+		throw Core::BadLogicException(TXT("Failed to downcast node type"));
+
+	return static_cast<const T*>(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Downcast the node to its concrete node type or throw if not that type. The
+//! check uses the stored node type rather than RTTI.
+
+template<typename T>
+inline T* Node::as()
+{
+	if (m_type != T::NODE_TYPE)
+		throw Core::BadLogicException(TXT("Failed to downcast node type"));
+
+	return static_cast<T*>(this);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Set the parent node.
 
@@ -132,6 +310,17 @@ inline void Node::setParent(Node* parent_)
 	m_parent = parent_;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Set the span of the document source the node was read from.
+
+inline void Node::setSource(size_t begin, size_t end)
+{
+	ASSERT(begin < end);
+
+	m_sourceBegin = begin;
+	m_sourceEnd = end;
+}
+
 //namespace XML
 }
 
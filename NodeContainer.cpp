@@ -5,6 +5,8 @@
 
 #include "Common.hpp"
 #include "NodeContainer.hpp"
+#include "Document.hpp"
+#include "ElementNode.hpp"
 #include <Core/InvalidArgException.hpp>
 #include <Core/StringUtils.hpp>
 
@@ -16,15 +18,32 @@ namespace XML
 
 NodeContainer::NodeContainer(Node* parent)
 	: m_parent(parent)
-	, m_childNodes()
+	, m_firstChild()
+	, m_lastChild(nullptr)
+	, m_childCount(0)
+	, m_index()
+	, m_indexValid(false)
 {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Destructor.
+//! Destructor. The children are unlinked one at a time so that releasing a
+//! long list of siblings doesn't recurse through the chain of links. A child
+//! may outlive the document and its source text, so its span is dropped.
 
 NodeContainer::~NodeContainer()
 {
+	while (!m_firstChild.empty())
+	{
+		NodePtr next = m_firstChild->m_nextSibling;
+
+		m_firstChild->m_nextSibling.reset();
+		m_firstChild->m_prevSibling = nullptr;
+		m_firstChild->m_parent = nullptr;
+		m_firstChild->clearSource();
+
+		m_firstChild = next;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -32,10 +51,13 @@ NodeContainer::~NodeContainer()
 
 NodePtr NodeContainer::getChild(size_t index) const
 {
-	if (index >= m_childNodes.size())
+	if (index >= m_childCount)
 		throw Core::InvalidArgException(Core::fmt(TXT("Invalid child node index '%Iu'"), index));
 
-	return m_childNodes[index];
+	if (!m_indexValid)
+		buildIndex();
+
+	return NodePtr(m_index[index], true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,17 +65,262 @@ NodePtr NodeContainer::getChild(size_t index) const
 
 void NodeContainer::appendChild(NodePtr& node)
 {
-	// Validate node.
+	validateChild(node);
+
+	linkChild(node, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert a child node before an existing child node. If no existing child
+//! node is provided the node is appended.
+
+void NodeContainer::insertChild(NodePtr& node, const NodePtr& before)
+{
+	if (before.empty())
+	{
+		appendChild(node);
+		return;
+	}
+
+	if (before->m_parent != m_parent)
+		throw Core::InvalidArgException(TXT("Failed to insert a node because the insertion point is not a child node"));
+
+	validateChild(node);
+
+	linkChild(node, before.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a child node.
+
+void NodeContainer::removeChild(const NodePtr& node)
+{
+	if ( (node.empty()) || (node->m_parent != m_parent) )
+		throw Core::InvalidArgException(TXT("Failed to remove a node because it is not a child node"));
+
+	// Keep the node alive whilst unlinking as the caller may be holding a
+	// reference to the very link we're about to overwrite.
+	NodePtr child = node;
+	Node*   prev  = child->m_prevSibling;
+	Node*   next  = child->m_nextSibling.get();
+
+	if (next != nullptr)
+		next->m_prevSibling = prev;
+	else
+		m_lastChild = prev;
+
+	NodePtr& link = (prev != nullptr) ? prev->m_nextSibling : m_firstChild;
+
+	link = child->m_nextSibling;
+
+	child->m_nextSibling.reset();
+	child->m_prevSibling = nullptr;
+	child->m_parent = nullptr;
+
+	--m_childCount;
+	m_indexValid = false;
+
+	if (m_parent->type() == DOCUMENT_NODE)
+		static_cast<Document*>(m_parent)->onChildUnlinked(child.get());
+
+	m_parent->invalidateSource();
+
+	Document* document = m_parent->ownerDocument();
+
+	if (document != nullptr)
+	{
+		// The subtree's source spans are only valid within this document.
+		if (document->hasSourceText())
+			clearSource(child.get());
+
+		document->onSubtreeUnlinked(child.get());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the container for a node, if it is a container node type. This uses
+//! the node type to find the mix-in rather than a cross-cast.
+
+const NodeContainer* NodeContainer::fromNode(const Node* node)
+{
+	switch (node->type())
+	{
+		case DOCUMENT_NODE:		return static_cast<const Document*>(node);
+		case ELEMENT_NODE:		return static_cast<const ElementNode*>(node);
+		case TEXT_NODE:
+		case COMMENT_NODE:
+		case PROCESSING_NODE:
+		case DOCTYPE_NODE:
+		case CDATA_NODE:
+		default:				break;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the container for a node, if it is a container node type.
+
+NodeContainer* NodeContainer::fromNode(Node* node)
+{
+	return const_cast<NodeContainer*>(fromNode(static_cast<const Node*>(node)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate a node before it is linked in as a child.
+
+void NodeContainer::validateChild(const NodePtr& node) const
+{
 	if (node->type() == DOCUMENT_NODE)
 		throw Core::InvalidArgException(TXT("Failed to append a node because it's a Document node"));
 
 	if (node->hasParent())
 		throw Core::InvalidArgException(Core::fmt(TXT("Failed to append a '%s' node because it is already part of a document"), node->typeStr()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Link a node in as a child before an existing child node. If there is no
+//! existing node it is linked in as the last child. The owning document, and
+//! whether anything follows the node, is found by walking up to the root.
+
+void NodeContainer::linkChild(const NodePtr& node, Node* before)
+{
+	linkSibling(node, before);
+
+	// Find the owning document and if nothing now follows the node.
+	bool  last = (before == nullptr);
+	Node* root = m_parent;
+
+	for (; root->m_parent != nullptr; root = root->m_parent)
+	{
+		if (!root->m_nextSibling.empty())
+			last = false;
+	}
+
+	if (root->type() == DOCUMENT_NODE)
+		notifyLinked(node.get(), static_cast<Document*>(root), last);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Link a node in as the last child when the container is known to be the
+//! last open one in the document being read, if any. This avoids walking up
+//! to the root for every node read.
+
+void NodeContainer::appendLast(const NodePtr& node, Document* document)
+{
+	ASSERT(!node->hasParent());
+
+	linkSibling(node, nullptr);
+
+	if (document != nullptr)
+		notifyLinked(node.get(), document, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Link a node into the list of child nodes before an existing child node. If
+//! there is no existing node it is linked in as the last child.
+
+void NodeContainer::linkSibling(const NodePtr& node, Node* before)
+{
+	Node* child = node.get();
+
+	if (before == nullptr)
+	{
+		child->m_prevSibling = m_lastChild;
+
+		if (m_lastChild != nullptr)
+			m_lastChild->m_nextSibling = node;
+		else
+			m_firstChild = node;
+
+		m_lastChild = child;
+
+		// Only maintain the index once it's been asked for.
+		if (m_indexValid)
+			m_index.push_back(child);
+	}
+	else
+	{
+		Node*    prev = before->m_prevSibling;
+		NodePtr& link = (prev != nullptr) ? prev->m_nextSibling : m_firstChild;
+
+		child->m_nextSibling = link;
+		child->m_prevSibling = prev;
+		before->m_prevSibling = child;
+
+		link = node;
+
+		m_indexValid = false;
+	}
+
+	child->setParent(m_parent);
+	m_parent->invalidateSource();
+
+	++m_childCount;
+
+	if (m_parent->type() == DOCUMENT_NODE)
+		static_cast<Document*>(m_parent)->onChildLinked(child, (before == nullptr));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Notify the owning document that a subtree has been linked in. The subtree
+//! is last if nothing follows it in document order.
+
+void NodeContainer::notifyLinked(Node* child, Document* document, bool last)
+{
+	// Any source spans the subtree brings with it belong to another source.
+	if (document->hasSourceText())
+		clearSource(child);
+
+	document->onSubtreeLinked(child, last);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the index of child nodes.
+
+void NodeContainer::buildIndex() const
+{
+	m_index.clear();
+	m_index.reserve(m_childCount);
+
+	for (Node* node = m_firstChild.get(); node != nullptr; node = node->m_nextSibling.get())
+		m_index.push_back(node);
+
+	m_indexValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drop the source spans of the nodes in a subtree. The subtree is walked with
+//! an explicit stack, so that it's safe with a subtree of any depth.
+
+void NodeContainer::clearSource(Node* subtree)
+{
+	const NodeContainer* root = fromNode(subtree);
+
+	// Avoid the stack for a lone node, such as one just read.
+	if ( (root == nullptr) || (!root->hasChildren()) )
+	{
+		subtree->clearSource();
+		return;
+	}
+
+	std::vector<Node*> pending(1, subtree);
+
+	while (!pending.empty())
+	{
+		Node* node = pending.back();
+
+		pending.pop_back();
+		node->clearSource();
+
+		const NodeContainer* container = fromNode(node);
 
-	// Add to the children.
-	m_childNodes.push_back(node);
+		if (container == nullptr)
+			continue;
 
-	node->setParent(m_parent);
+		for (Node* child = container->m_firstChild.get(); child != nullptr; child = child->m_nextSibling.get())
+			pending.push_back(child);
+	}
 }
 
 //namespace XML
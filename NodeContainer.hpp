@@ -13,7 +13,7 @@
 
 #include "Node.hpp"
 #include <vector>
-#include <Core/BadLogicException.hpp>
+#include <iterator>
 
 namespace XML
 {
@@ -25,14 +25,72 @@ typedef std::vector<NodePtr> Nodes;
 //! The mix-in class used for node types that can contain other nodes. The outer
 //! parent node is held internally so that we can fix up the child nodes here
 //! automatically.
+//!
+//! The children are stored as an intrusive list threaded through the nodes
+//! sibling links so that appending, inserting and removing a child is O(1)
+//! and never reallocates. Access by index is supported through an array that
+//! is only built on demand.
 
 class NodeContainer /*: private NotCopyable*/
 {
 public:
+	////////////////////////////////////////////////////////////////////////////
+	//! The iterator used to walk the child nodes. It holds a pointer to the
+	//! link that owns the current node so that dereferencing it does not touch
+	//! the nodes ref-count.
+
+	class ChildIterator
+	{
+	public:
+		//! The iterator category.
+		typedef std::forward_iterator_tag iterator_category;
+		//! The type of value iterated.
+		typedef NodePtr value_type;
+		//! The type used for the distance between iterators.
+		typedef ptrdiff_t difference_type;
+		//! The pointer to value type.
+		typedef const NodePtr* pointer;
+		//! The reference to value type.
+		typedef const NodePtr& reference;
+
+		//! Default constructor.
+		ChildIterator();
+
+		//! Construction from the link to the current node.
+		explicit ChildIterator(const NodePtr* link);
+
+		//! Dereference operator.
+		reference operator*() const;
+
+		//! Member access operator.
+		pointer operator->() const;
+
+		//! Pre-increment operator.
+		ChildIterator& operator++();
+
+		//! Post-increment operator.
+		ChildIterator operator++(int);
+
+		//! Equivalence operator.
+		bool operator==(const ChildIterator& rhs) const;
+
+		//! Non-equivalence operator.
+		bool operator!=(const ChildIterator& rhs) const;
+
+	private:
+		//
+		// Members.
+		//
+		const NodePtr*	m_link;		//!< The link to the current node.
+
+		//! Get the current node.
+		const Node* node() const;
+	};
+
 	//! The container const iterator.
-	typedef Nodes::const_iterator const_iterator;
+	typedef ChildIterator const_iterator;
 	//! The container iterator.
-	typedef Nodes::iterator iterator;
+	typedef ChildIterator iterator;
 
 	//
 	// Properties.
@@ -51,6 +109,12 @@ public:
 	template<typename T>
 	Core::RefCntPtr<T> getChild(size_t index) const;
 
+	//! Get the first child node.
+	const NodePtr& firstChild() const;
+
+	//! Get the last child node.
+	NodePtr lastChild() const;
+
 	//! Get the start iterator for the child nodes.
 	const_iterator beginChild() const;
 
@@ -74,6 +138,26 @@ public:
 	template<typename T>
 	void appendChild(Core::RefCntPtr<T> node);
 
+	//! Insert a child node before an existing child node.
+	void insertChild(NodePtr& node, const NodePtr& before);
+
+	//! Insert a child node before an existing child node.
+	template<typename T>
+	void insertChild(Core::RefCntPtr<T> node, const NodePtr& before);
+
+	//! Remove a child node.
+	void removeChild(const NodePtr& node);
+
+	//
+	// Class methods.
+	//
+
+	//! Get the container for a node, if it is a container node type.
+	static const NodeContainer* fromNode(const Node* node);
+
+	//! Get the container for a node, if it is a container node type.
+	static NodeContainer* fromNode(Node* node);
+
 protected:
 	//! Constructor.
 	NodeContainer(Node* parent);
@@ -82,23 +166,147 @@ protected:
 	virtual ~NodeContainer();
 
 private:
+	//! The container type used for the index of child nodes.
+	typedef std::vector<Node*> NodeIndex;
+
 	//
 	// Members.
 	//
-	Node*	m_parent;			//!< The outer parent node.
-	Nodes	m_childNodes;		//!< The collection of child nodes.
+	Node*				m_parent;			//!< The outer parent node.
+	NodePtr				m_firstChild;		//!< The first child node.
+	Node*				m_lastChild;		//!< The last child node.
+	size_t				m_childCount;		//!< The number of child nodes.
+	mutable NodeIndex	m_index;			//!< The child nodes by index.
+	mutable bool		m_indexValid;		//!< Is the index up-to-date?
+
+	//
+	// Internal methods.
+	//
+
+	//! Validate a node before it is linked in as a child.
+	void validateChild(const NodePtr& node) const;
+
+	//! Link a node in as a child before an existing child node.
+	void linkChild(const NodePtr& node, Node* before);
+
+	//! Link a node in as the last child of a document being read.
+	void appendLast(const NodePtr& node, Document* document);
+
+	//! Link a node into the list of child nodes.
+	void linkSibling(const NodePtr& node, Node* before);
+
+	//! Notify the owning document that a subtree has been linked in.
+	static void notifyLinked(Node* child, Document* document, bool last);
+
+	//! Build the index of child nodes.
+	void buildIndex() const;
+
+	//! Drop the source spans of the nodes in a subtree.
+	static void clearSource(Node* subtree);
+
+	//
+	// Friends.
+	//
+
+	//! Allow the reader to append nodes to the document it's building.
+	friend class Reader;
 
 	// NotCopyable.
 	NodeContainer(const NodeContainer&);
 	NodeContainer& operator=(const NodeContainer);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline NodeContainer::ChildIterator::ChildIterator()
+	: m_link(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from the link to the current node.
+
+inline NodeContainer::ChildIterator::ChildIterator(const NodePtr* link)
+	: m_link(link)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dereference operator.
+
+inline NodeContainer::ChildIterator::reference NodeContainer::ChildIterator::operator*() const
+{
+	ASSERT(node() != nullptr);
+
+	return *m_link;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Member access operator.
+
+inline NodeContainer::ChildIterator::pointer NodeContainer::ChildIterator::operator->() const
+{
+	ASSERT(node() != nullptr);
+
+	return m_link;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Pre-increment operator.
+
+inline NodeContainer::ChildIterator& NodeContainer::ChildIterator::operator++()
+{
+	ASSERT(node() != nullptr);
+
+	m_link = &(*m_link)->nextSibling();
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Post-increment operator.
+
+inline NodeContainer::ChildIterator NodeContainer::ChildIterator::operator++(int)
+{
+	ChildIterator current(*this);
+
+	operator++();
+
+	return current;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Equivalence operator. Iterators are equivalent when they refer to the same
+//! node, which means all iterators at the end of the sequence are equivalent.
+
+inline bool NodeContainer::ChildIterator::operator==(const ChildIterator& rhs) const
+{
+	return (node() == rhs.node());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Non-equivalence operator.
+
+inline bool NodeContainer::ChildIterator::operator!=(const ChildIterator& rhs) const
+{
+	return !operator==(rhs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current node.
+
+inline const Node* NodeContainer::ChildIterator::node() const
+{
+	return (m_link != nullptr) ? m_link->get() : nullptr;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Query if the node has any child nodes.
 
 inline bool NodeContainer::hasChildren() const
 {
-	return !m_childNodes.empty();
+	return !m_firstChild.empty();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -106,7 +314,7 @@ inline bool NodeContainer::hasChildren() const
 
 inline size_t NodeContainer::getChildCount() const
 {
-	return m_childNodes.size();
+	return m_childCount;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -115,12 +323,25 @@ inline size_t NodeContainer::getChildCount() const
 template<typename T>
 inline Core::RefCntPtr<T> NodeContainer::getChild(size_t index) const
 {
-	Core::RefCntPtr<T> node = Core::dynamic_ptr_cast<T>(getChild(index));
+	NodePtr node = getChild(index);
+
+	return Core::RefCntPtr<T>(node->as<T>(), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the first child node.
+
+inline const NodePtr& NodeContainer::firstChild() const
+{
+	return m_firstChild;
+}
 
-	if (node.get() == nullptr)
-		throw Core::BadLogicException(TXT("Failed to downcast node type"));
+////////////////////////////////////////////////////////////////////////////////
+//! Get the last child node.
 
-	return node;
+inline NodePtr NodeContainer::lastChild() const
+{
+	return NodePtr(m_lastChild, true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -128,7 +349,7 @@ inline Core::RefCntPtr<T> NodeContainer::getChild(size_t index) const
 
 inline NodeContainer::const_iterator NodeContainer::beginChild() const
 {
-	return m_childNodes.begin();
+	return const_iterator(&m_firstChild);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -136,7 +357,10 @@ inline NodeContainer::const_iterator NodeContainer::beginChild() const
 
 inline NodeContainer::const_iterator NodeContainer::endChild() const
 {
-	return m_childNodes.end();
+	if (m_lastChild == nullptr)
+		return const_iterator(&m_firstChild);
+
+	return const_iterator(&m_lastChild->nextSibling());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -144,7 +368,7 @@ inline NodeContainer::const_iterator NodeContainer::endChild() const
 
 inline NodeContainer::iterator NodeContainer::beginChild()
 {
-	return m_childNodes.begin();
+	return iterator(&m_firstChild);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -152,10 +376,15 @@ inline NodeContainer::iterator NodeContainer::beginChild()
 
 inline NodeContainer::iterator NodeContainer::endChild()
 {
-	return m_childNodes.end();
+	if (m_lastChild == nullptr)
+		return iterator(&m_firstChild);
+
+	return iterator(&m_lastChild->nextSibling());
 }
 
+////////////////////////////////////////////////////////////////////////////////
 //! Append a child node.
+
 template<typename T>
 inline void NodeContainer::appendChild(Core::RefCntPtr<T> node)
 {
@@ -164,6 +393,17 @@ inline void NodeContainer::appendChild(Core::RefCntPtr<T> node)
 	appendChild(p);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Insert a child node before an existing child node.
+
+template<typename T>
+inline void NodeContainer::insertChild(Core::RefCntPtr<T> node, const NodePtr& before)
+{
+	NodePtr p = node;
+
+	insertChild(p, before);
+}
+
 //namespace XML
 }
 
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeVisitor.hpp
+//! \brief  The NodeVisitor class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_NODEVISITOR_HPP
+#define XML_NODEVISITOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace XML
+{
+
+// Forward declarations.
+class Document;
+class ElementNode;
+class TextNode;
+class CommentNode;
+class ProcessingNode;
+class DocTypeNode;
+class CDataNode;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The interface for a class that receives a typed callback for each node when
+//! a tree is walked by a TreeWalker. Container nodes are entered before their
+//! children (pre-order) and left after them (post-order). The default
+//! implementations do nothing and continue the walk.
+
+class NodeVisitor
+{
+public:
+	//! The action the walker should take after a callback.
+	enum Action
+	{
+		CONTINUE,			//!< Continue walking the tree.
+		SKIP_CHILDREN,		//!< Don't walk the children of the node just entered.
+		STOP					//!< Abandon walking the tree.
+	};
+
+	//
+	// Methods.
+	//
+
+	//! Enter the document node.
+	virtual Action enterDocument(const Document& document);
+
+	//! Leave the document node.
+	virtual Action leaveDocument(const Document& document);
+
+	//! Enter an element node.
+	virtual Action enterElement(const ElementNode& element);
+
+	//! Leave an element node.
+	virtual Action leaveElement(const ElementNode& element);
+
+	//! Visit a text node.
+	virtual Action visitText(const TextNode& text);
+
+	//! Visit a comment node.
+	virtual Action visitComment(const CommentNode& comment);
+
+	//! Visit a processing instruction node.
+	virtual Action visitProcessing(const ProcessingNode& processing);
+
+	//! Visit a document type node.
+	virtual Action visitDocType(const DocTypeNode& docType);
+
+	//! Visit a CDATA section node.
+	virtual Action visitCData(const CDataNode& cdata);
+
+protected:
+	//! Default constructor.
+	NodeVisitor();
+
+	//! Destructor.
+	virtual ~NodeVisitor();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline NodeVisitor::NodeVisitor()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline NodeVisitor::~NodeVisitor()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Enter the document node.
+
+inline NodeVisitor::Action NodeVisitor::enterDocument(const Document& /*document*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Leave the document node.
+
+inline NodeVisitor::Action NodeVisitor::leaveDocument(const Document& /*document*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Enter an element node.
+
+inline NodeVisitor::Action NodeVisitor::enterElement(const ElementNode& /*element*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Leave an element node.
+
+inline NodeVisitor::Action NodeVisitor::leaveElement(const ElementNode& /*element*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit a text node.
+
+inline NodeVisitor::Action NodeVisitor::visitText(const TextNode& /*text*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit a comment node.
+
+inline NodeVisitor::Action NodeVisitor::visitComment(const CommentNode& /*comment*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit a processing instruction node.
+
+inline NodeVisitor::Action NodeVisitor::visitProcessing(const ProcessingNode& /*processing*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit a document type node.
+
+inline NodeVisitor::Action NodeVisitor::visitDocType(const DocTypeNode& /*docType*/)
+{
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Visit a CDATA section node.
+
+inline NodeVisitor::Action NodeVisitor::visitCData(const CDataNode& /*cdata*/)
+{
+	return CONTINUE;
+}
+
+//namespace XML
+}
+
+#endif // XML_NODEVISITOR_HPP
@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   OutputBuffer.cpp
+//! \brief  The OutputBuffer class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "OutputBuffer.hpp"
+#include <cstring>
+
+namespace XML
+{
+
+//! The length of the runs of white-space that the indentation is written from.
+static const size_t INDENT_RUN_LENGTH = 64;
+
+//! The run of spaces that the indentation is written from.
+static const tchar SPACES[INDENT_RUN_LENGTH+1] = TXT("                                                                ");
+
+//! The run of tabs that the indentation is written from.
+static const tchar TABS[INDENT_RUN_LENGTH+1] = TXT("\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t")
+                                               TXT("\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the static run of white-space that the indentation for a style can be
+//! written from, which is when the style is all spaces or all tabs. Returns
+//! null for any other style.
+
+static const tchar* findIndentRun(const tchar* indentStyle)
+{
+	const tchar first = *indentStyle;
+
+	if ( (first != TXT(' ')) && (first != TXT('\t')) )
+		return nullptr;
+
+	for (const tchar* current = indentStyle; *current != TXT('\0'); ++current)
+	{
+		if (*current != first)
+			return nullptr;
+	}
+
+	return (first == TXT(' ')) ? SPACES : TABS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from the formatting options.
+
+OutputBuffer::OutputBuffer(bool formatting, const tchar* indentStyle_, const tchar* terminator_)
+	: m_indentStyle(indentStyle_)
+	, m_indentRun(findIndentRun(indentStyle_))
+	, m_terminator((formatting) ? terminator_ : TXT(""))
+	, m_buffer()
+	, m_sink(nullptr)
+	, m_reference(false)
+	, m_segments()
+	, m_referenced(0)
+	, m_chunks()
+	, m_array(nullptr)
+	, m_capacity(0)
+	, m_length(0)
+	, m_fixed(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+OutputBuffer::~OutputBuffer()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send the output to a sink, in chunks of roughly BUFFER_SIZE characters. The
+//! large values are only referenced if the caller guarantees that they will
+//! outlive the next flush.
+
+void OutputBuffer::attach(OutputSink& sink, bool referenceValues)
+{
+	m_sink = &sink;
+	m_reference = referenceValues;
+	m_buffer.reserve(BUFFER_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the output into a fixed size array, rather than the buffer. The array
+//! can be null, with no capacity, to only measure the output.
+
+void OutputBuffer::attach(tchar* array, size_t capacity)
+{
+	ASSERT( (array != nullptr) || (capacity == 0) );
+
+	m_array = array;
+	m_capacity = capacity;
+	m_length = 0;
+	m_fixed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reserve space for a further length characters of output, when it's kept in
+//! the buffer.
+
+void OutputBuffer::reserve(size_t length_)
+{
+	if (isBuffered())
+		m_buffer.reserve(m_buffer.size() + length_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Take the output, when it's not sent to a sink. The buffer is handed over,
+//! rather than copied.
+
+void OutputBuffer::swap(tstring& output)
+{
+	ASSERT(isBuffered());
+
+	m_buffer.swap(output);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the entity or character reference used to write a character, or null
+//! if it's written as is. The quotes and white-space are only escaped in
+//! attribute values, which are always written within double quotes, so that
+//! a parser doesn't normalise the white-space.
+
+static const tchar* escapeChar(tchar character, bool attribute)
+{
+	switch (character)
+	{
+		case TXT('<'):	return TXT("&lt;");
+		case TXT('>'):	return TXT("&gt;");
+		case TXT('&'):	return TXT("&amp;");
+		case TXT('\"'):	return (attribute) ? TXT("&quot;") : nullptr;
+		case TXT('\''):	return (attribute) ? TXT("&apos;") : nullptr;
+		case TXT('\t'):	return (attribute) ? TXT("&#9;")   : nullptr;
+		case TXT('\n'):	return (attribute) ? TXT("&#10;")  : nullptr;
+		case TXT('\r'):	return (attribute) ? TXT("&#13;")  : nullptr;
+		default:		return nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a word with every byte set to a value.
+
+static inline size_t repeatByte(unsigned char value)
+{
+	return (~static_cast<size_t>(0) / 0xFF) * value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if any byte of a word has a value. The byte is zeroed by the XOR and
+//! a zero byte is the only one whose top bit is set by subtracting 1 but not
+//! already set, so the test is exact for the word as a whole, if not for which
+//! byte matched.
+
+static inline bool hasByte(size_t word, unsigned char value)
+{
+	const size_t bytes = word ^ repeatByte(value);
+
+	return (((bytes - repeatByte(0x01)) & ~bytes & repeatByte(0x80)) != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a word of narrow characters contains any that are escaped.
+
+static bool hasEscapedChar(size_t word, bool attribute)
+{
+	if ( (hasByte(word, '<')) || (hasByte(word, '>')) || (hasByte(word, '&')) )
+		return true;
+
+	if (!attribute)
+		return false;
+
+	return ( (hasByte(word, '\"')) || (hasByte(word, '\'')) || (hasByte(word, '\t'))
+	      || (hasByte(word, '\n')) || (hasByte(word, '\r')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the next character that is escaped, returning the end if there are
+//! none. Narrow characters are checked a word at a time, which skips the runs
+//! that need no escaping, including any non-ASCII bytes, with a few integer
+//! operations per word. The word with the match, the characters left over and
+//! all wide characters are then checked one at a time, where as none of the
+//! escaped characters come after '>' most are skipped with a single comparison.
+
+static const tchar* findEscapedChar(const tchar* begin, const tchar* end, bool attribute, const tchar*& reference)
+{
+	const tchar* current = begin;
+
+	if (sizeof(tchar) == 1)
+	{
+		size_t word;
+
+		while (static_cast<size_t>(end - current) >= sizeof(word))
+		{
+			std::memcpy(&word, current, sizeof(word));
+
+			if (hasEscapedChar(word, attribute))
+				break;
+
+			current += sizeof(word);
+		}
+	}
+
+	for (; current != end; ++current)
+	{
+		if (static_cast<utchar>(*current) > TXT('>'))
+			continue;
+
+		reference = escapeChar(*current, attribute);
+
+		if (reference != nullptr)
+			return current;
+	}
+
+	return end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a text or attribute value, escaping it as needed. The runs of
+//! characters that don't need escaping are found by findEscapedChar() and
+//! appended in one go, or referenced if large.
+
+void OutputBuffer::writeEscaped(const tstring& text, bool attribute)
+{
+	const tchar* run = text.data();
+	const tchar* end = run + text.length();
+	const tchar* reference = nullptr;
+
+	const tchar* current = findEscapedChar(run, end, attribute, reference);
+
+	while (current != end)
+	{
+		writeValue(run, current-run);
+		append(reference, tstrlen(reference));
+		run = current+1;
+		current = findEscapedChar(run, end, attribute, reference);
+	}
+
+	writeValue(run, end-run);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append the indentation for a depth, if formatting. A style of spaces or tabs
+//! is written from a static run of them, a run at a time, and any other style
+//! is written once per level, so that nothing is allocated.
+
+void OutputBuffer::writeIndentation(size_t depth)
+{
+	if (m_terminator.empty())
+		return;
+
+	if (m_indentRun == nullptr)
+	{
+		for (size_t i = 0; i != depth; ++i)
+			append(m_indentStyle.data(), m_indentStyle.length());
+
+		return;
+	}
+
+	size_t length = depth * m_indentStyle.length();
+
+	while (length != 0)
+	{
+		const size_t chunk = std::min(length, INDENT_RUN_LENGTH);
+
+		append(m_indentRun, chunk);
+		length -= chunk;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the buffer to the sink, if there is one, and empty it. If any values
+//! have been referenced the buffer is written along with them in a single
+//! gather write.
+
+void OutputBuffer::flush()
+{
+	if (m_sink == nullptr)
+		return;
+
+	if (m_segments.empty())
+	{
+		if (!m_buffer.empty())
+			m_sink->write(m_buffer.data(), m_buffer.size());
+	}
+	else
+	{
+		writeReference(nullptr, 0);
+
+		m_chunks.clear();
+
+		for (Segments::const_iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+		{
+			if (it->m_length == 0)
+				continue;
+
+			const tchar*            text = (it->m_text != nullptr) ? it->m_text : m_buffer.data() + it->m_offset;
+			const OutputSink::Chunk chunk = { text, it->m_length };
+
+			m_chunks.push_back(chunk);
+		}
+
+		m_sink->writeChunks(&m_chunks[0], m_chunks.size());
+
+		m_segments.clear();
+		m_referenced = 0;
+	}
+
+	m_buffer.erase();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a reference to a value to the output, after the markup buffered since
+//! the last one. The buffer is recorded by offset as it may grow before the
+//! next flush.
+
+void OutputBuffer::writeReference(const tchar* text, size_t length)
+{
+	size_t offset = 0;
+
+	if (!m_segments.empty())
+	{
+		const Segment& last = m_segments.back();
+
+		offset = (last.m_text == nullptr) ? last.m_offset + last.m_length : last.m_offset;
+	}
+
+	const size_t buffered = m_buffer.size() - offset;
+
+	if (buffered != 0)
+	{
+		const Segment markup = { nullptr, offset, buffered };
+
+		m_segments.push_back(markup);
+	}
+
+	if (length != 0)
+	{
+		const Segment value = { text, m_buffer.size(), length };
+
+		m_segments.push_back(value);
+		m_referenced += length;
+	}
+}
+
+//namespace XML
+}
@@ -0,0 +1,259 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   OutputBuffer.hpp
+//! \brief  The OutputBuffer class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_OUTPUTBUFFER_HPP
+#define XML_OUTPUTBUFFER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "OutputSink.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The buffer that serialised XML is built in. It provides the primitives for
+//! appending markup, escaped values and formatting, so that they're shared by
+//! the different writers. The output is either kept in the buffer or, when a
+//! sink is attached, passed on to the sink each time the buffer fills.
+//!
+//! When the values outlive each flush, such as those owned by the nodes of a
+//! document, the large ones can be referenced rather than copied. The buffer
+//! then only holds the generated markup and is written along with the values
+//! as a sequence of chunks in a single gather write.
+//!
+//! The output can also be written directly into a fixed size array supplied by
+//! the caller, without any buffering. Any output that doesn't fit is dropped,
+//! but still counted, so that the array can also be left out to measure it.
+
+class OutputBuffer /*: private NotCopyable*/
+{
+public:
+	//! The number of characters buffered before they're written to a sink.
+	static const size_t BUFFER_SIZE = 16384;
+
+	//! The length from which a value is referenced, rather than copied.
+	static const size_t REFERENCE_THRESHOLD = 256;
+
+	//! Construction from the formatting options.
+	OutputBuffer(bool formatting, const tchar* indentStyle, const tchar* terminator);
+
+	//! Destructor.
+	~OutputBuffer();
+
+	//
+	// Properties.
+	//
+
+	//! Get the string used for each level of indentation.
+	const tstring& indentStyle() const;
+
+	//! Get the line terminator, which is empty if not formatting.
+	const tstring& terminator() const;
+
+	//
+	// Methods.
+	//
+
+	//! Send the output to a sink.
+	void attach(OutputSink& sink, bool referenceValues);
+
+	//! Write the output into a fixed size array.
+	void attach(tchar* array, size_t capacity);
+
+	//! Query if the output is kept in the buffer.
+	bool isBuffered() const;
+
+	//! Get the length of the output written to a fixed size array.
+	size_t length() const;
+
+	//! Reserve space for more output, when it's kept in the buffer.
+	void reserve(size_t length);
+
+	//! Take the output, when it's not sent to a sink.
+	void swap(tstring& output);
+
+	//! Append a string.
+	void write(const tstring& text);
+
+	//! Append a string literal.
+	void write(const tchar* text, size_t length);
+
+	//! Append a value, which is written as is.
+	void writeValue(const tchar* text, size_t length);
+
+	//! Append a text or attribute value, escaping it as needed.
+	void writeEscaped(const tstring& text, bool attribute);
+
+	//! Append the indentation for a depth.
+	void writeIndentation(size_t depth);
+
+	//! Append the line terminator.
+	void writeTerminator();
+
+	//! Write the buffer to the sink, if there is one and the buffer's full.
+	void flushIfFull();
+
+	//! Write the buffer to the sink, if there is one.
+	void flush();
+
+private:
+	//! A part of the output, which is either in the buffer or a referenced value.
+	struct Segment
+	{
+		const tchar*	m_text;		//!< The value, or null if in the buffer.
+		size_t			m_offset;	//!< The offset in the buffer.
+		size_t			m_length;	//!< The length of the text.
+	};
+
+	//! The container type used for the parts of the output.
+	typedef std::vector<Segment> Segments;
+	//! The container type used for the chunks in a gather write.
+	typedef std::vector<OutputSink::Chunk> Chunks;
+
+	//
+	// Members.
+	//
+	tstring			m_indentStyle;	//!< The string to use for indenting.
+	const tchar*	m_indentRun;	//!< The run of characters the indentation is written from, if any.
+	tstring			m_terminator;	//!< The line terminator, if formatting.
+	tstring			m_buffer;		//!< The output buffer.
+	OutputSink*		m_sink;			//!< The sink to write the buffer to, if streaming.
+	bool			m_reference;	//!< Reference the large values, rather than copy them?
+	Segments		m_segments;		//!< The parts of the output written since the last flush.
+	size_t			m_referenced;	//!< The length of the referenced values.
+	Chunks			m_chunks;		//!< The chunks for the gather write.
+	tchar*			m_array;		//!< The fixed size array to write to, if any.
+	size_t			m_capacity;		//!< The capacity of the fixed size array.
+	size_t			m_length;		//!< The length of the output for the array.
+	bool			m_fixed;		//!< Is the output written to a fixed size array?
+
+	//
+	// Internal methods.
+	//
+
+	//! Append text to the buffer or fixed size array.
+	void append(const tchar* text, size_t length);
+
+	//! Add a reference to a value to the output.
+	void writeReference(const tchar* text, size_t length);
+
+	// NotCopyable.
+	OutputBuffer(const OutputBuffer&);
+	OutputBuffer& operator=(const OutputBuffer);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the string used for each level of indentation.
+
+inline const tstring& OutputBuffer::indentStyle() const
+{
+	return m_indentStyle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the line terminator, which is empty if not formatting.
+
+inline const tstring& OutputBuffer::terminator() const
+{
+	return m_terminator;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the output is kept in the buffer, rather than sent to a sink or
+//! written to a fixed size array.
+
+inline bool OutputBuffer::isBuffered() const
+{
+	return ( (m_sink == nullptr) && (!m_fixed) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the length of the output written to a fixed size array, which includes
+//! any that didn't fit.
+
+inline size_t OutputBuffer::length() const
+{
+	ASSERT(m_fixed);
+
+	return m_length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append text to the buffer or, if there is one, the fixed size array. Only
+//! as much as fits is copied to the array, but all of it is counted.
+
+inline void OutputBuffer::append(const tchar* text, size_t length_)
+{
+	if (!m_fixed)
+	{
+		m_buffer.append(text, length_);
+		return;
+	}
+
+	if (m_length < m_capacity)
+	{
+		const size_t copied = std::min(length_, m_capacity - m_length);
+
+		std::copy(text, text + copied, m_array + m_length);
+	}
+
+	m_length += length_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a string.
+
+inline void OutputBuffer::write(const tstring& text)
+{
+	append(text.data(), text.length());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a string literal.
+
+inline void OutputBuffer::write(const tchar* text, size_t length_)
+{
+	append(text, length_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a value, which is written as is. A large value is referenced, rather
+//! than copied, when it's known to outlive the next flush.
+
+inline void OutputBuffer::writeValue(const tchar* text, size_t length_)
+{
+	if ( (m_reference) && (length_ >= REFERENCE_THRESHOLD) )
+		writeReference(text, length_);
+	else
+		append(text, length_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append the line terminator.
+
+inline void OutputBuffer::writeTerminator()
+{
+	append(m_terminator.data(), m_terminator.length());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the buffer to the sink, if there is one and the buffer's full.
+
+inline void OutputBuffer::flushIfFull()
+{
+	if ( (m_sink != nullptr) && ((m_buffer.size() + m_referenced) >= BUFFER_SIZE) )
+		flush();
+}
+
+//namespace XML
+}
+
+#endif // XML_OUTPUTBUFFER_HPP
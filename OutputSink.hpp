@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   OutputSink.hpp
+//! \brief  The OutputSink class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_OUTPUTSINK_HPP
+#define XML_OUTPUTSINK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The interface for the destination of a stream of serialised XML. The text
+//! is passed on in chunks as it's written, rather than all at once, and so a
+//! client can also implement this to receive the output via a callback.
+//!
+//! The output can also be passed on as a sequence of chunks in a single call,
+//! some of which refer to the text in the nodes rather than a copy of it. By
+//! default each chunk is written in turn, but a sink can override this to
+//! use a gather write.
+
+class OutputSink
+{
+public:
+	//! A chunk of text in a gather write.
+	struct Chunk
+	{
+		const tchar*	m_text;		//!< The text.
+		size_t			m_length;	//!< The length of the text.
+	};
+
+	//! Write a chunk of text to the destination.
+	virtual void write(const tchar* text, size_t length) = 0; // throw(IOException)
+
+	//! Write a sequence of chunks of text to the destination.
+	virtual void writeChunks(const Chunk* chunks, size_t count); // throw(IOException)
+
+protected:
+	//! Destructor.
+	virtual ~OutputSink() {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a sequence of chunks of text to the destination. The chunks are only
+//! valid for the duration of the call.
+
+inline void OutputSink::writeChunks(const Chunk* chunks, size_t count)
+{
+	for (size_t i = 0; i != count; ++i)
+		write(chunks[i].m_text, chunks[i].m_length);
+}
+
+//namespace XML
+}
+
+#endif // XML_OUTPUTSINK_HPP
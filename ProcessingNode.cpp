@@ -13,27 +13,33 @@ namespace XML
 //! Default constructor.
 
 ProcessingNode::ProcessingNode()
-	: m_target()
+	: Node(NODE_TYPE)
+	, m_target()
 	, m_attributes()
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from a target.
 
 ProcessingNode::ProcessingNode(const tstring& target_)
-	: m_target(target_)
+	: Node(NODE_TYPE)
+	, m_target(target_)
 	, m_attributes()
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from a target and attributes.
 
 ProcessingNode::ProcessingNode(const tstring& target_, const Attributes& attributes)
-	: m_target(target_)
+	: Node(NODE_TYPE)
+	, m_target(target_)
 	, m_attributes(attributes)
 {
+	m_attributes.setOwner(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,6 +23,9 @@ namespace XML
 class ProcessingNode : public Node
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = PROCESSING_NODE;
+
 	//! Default constructor.
 	ProcessingNode();
 
@@ -36,9 +39,6 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the target.
 	const tstring& target() const;
 
@@ -65,14 +65,6 @@ private:
 //! The default ProcessingNode smart-pointer type.
 typedef Core::RefCntPtr<ProcessingNode> ProcessingNodePtr;
 
-////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
-
-inline NodeType ProcessingNode::type() const
-{
-	return PROCESSING_NODE;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the target.
 
@@ -87,6 +79,8 @@ inline const tstring& ProcessingNode::target() const
 inline void ProcessingNode::setTarget(const tstring& target_)
 {
 	m_target = target_;
+
+	notifyModified();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,8 @@
 #include "ProcessingNode.hpp"
 #include "DocTypeNode.hpp"
 #include "CDataNode.hpp"
+#include "XPathStreamMatcher.hpp"
+#include <algorithm>
 
 namespace XML
 {
@@ -20,6 +22,119 @@ namespace XML
 //! The stream character lookup table.
 static CharTable s_charTable;
 
+//! The longest reference name decoded, which allows for some leading zeros.
+static const size_t MAX_REFERENCE_LENGTH = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a single character or entity reference, such as "&amp;" or "&#60;",
+//! where the name is the text between the '&' and the ';'. Returns false if
+//! the reference isn't one of the predefined ones or can't be represented. A
+//! narrow character is a byte of a multi-byte encoding above ASCII, so only
+//! ASCII characters are decoded in a non-UNICODE build.
+
+static bool decodeReference(const tchar* begin, const tchar* end, tchar& character)
+{
+	const tstring name(begin, end);
+
+	if      (name == TXT("lt"))   character = TXT('<');
+	else if (name == TXT("gt"))   character = TXT('>');
+	else if (name == TXT("amp"))  character = TXT('&');
+	else if (name == TXT("quot")) character = TXT('\"');
+	else if (name == TXT("apos")) character = TXT('\'');
+	else if ( (name.length() > 1) && (name[0] == TXT('#')) )
+	{
+		const bool          hex = ( (name[1] == TXT('x')) || (name[1] == TXT('X')) );
+		const size_t        first = (hex) ? 2 : 1;
+		const unsigned long limit = (sizeof(tchar) == 1) ? 0x7F : static_cast<utchar>(~0);
+		unsigned long       value = 0;
+
+		if (first == name.length())
+			return false;
+
+		for (size_t i = first; i != name.length(); ++i)
+		{
+			const tchar digit = name[i];
+
+			if ( (digit >= TXT('0')) && (digit <= TXT('9')) )
+				value = (value * ((hex) ? 16 : 10)) + (digit - TXT('0'));
+			else if ( (hex) && (digit >= TXT('a')) && (digit <= TXT('f')) )
+				value = (value * 16) + (digit - TXT('a') + 10);
+			else if ( (hex) && (digit >= TXT('A')) && (digit <= TXT('F')) )
+				value = (value * 16) + (digit - TXT('A') + 10);
+			else
+				return false;
+
+			if (value > limit)
+				return false;
+		}
+
+		if (value == 0)
+			return false;
+
+		character = static_cast<tchar>(value);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode the predefined entity and character references in a text or
+//! attribute value. A value without any references, which is the usual case,
+//! is just copied. Any other references are left as is. The search for the end
+//! of a reference is bounded so that a stray '&' doesn't scan the rest of the
+//! value.
+
+static void decodeValue(const tchar* begin, const tchar* end, tstring& value)
+{
+	const tchar* current = std::find(begin, end, TXT('&'));
+
+	if (current == end)
+	{
+		value.assign(begin, end);
+		return;
+	}
+
+	value.assign(begin, current);
+
+	while (current != end)
+	{
+		const size_t remaining = end - current;
+		const tchar* last = current + std::min(remaining, MAX_REFERENCE_LENGTH+2);
+		const tchar* terminator = std::find(current, last, TXT(';'));
+		tchar        character;
+
+		if ( (terminator != last) && (decodeReference(current+1, terminator, character)) )
+		{
+			value += character;
+			current = terminator+1;
+		}
+		else
+		{
+			value += *current++;
+		}
+
+		const tchar* next = std::find(current, end, TXT('&'));
+
+		value.append(current, next);
+		current = next;
+	}
+}
+
+//! The parsers specialised for each combination of the discard flags, and for
+//! keeping the source.
+const Reader::Parser Reader::s_parsers[KEEP_SOURCE_PARSER+1] =
+{
+	&Reader::parseNodes<0x0>, &Reader::parseNodes<0x1>, &Reader::parseNodes<0x2>, &Reader::parseNodes<0x3>,
+	&Reader::parseNodes<0x4>, &Reader::parseNodes<0x5>, &Reader::parseNodes<0x6>, &Reader::parseNodes<0x7>,
+	&Reader::parseNodes<0x8>, &Reader::parseNodes<0x9>, &Reader::parseNodes<0xA>, &Reader::parseNodes<0xB>,
+	&Reader::parseNodes<0xC>, &Reader::parseNodes<0xD>, &Reader::parseNodes<0xE>, &Reader::parseNodes<0xF>,
+	&Reader::parseNodes<KEEP_SOURCE>,
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Default constructor.
 
@@ -29,6 +144,11 @@ Reader::Reader()
 	, m_current(nullptr)
 	, m_flags(DEFAULT)
 	, m_stack()
+	, m_matcher(nullptr)
+	, m_handler(nullptr)
+	, m_matchRoot(nullptr)
+	, m_rootFound(false)
+	, m_document(nullptr)
 {
 }
 
@@ -39,20 +159,6 @@ Reader::~Reader()
 {
 }
 
-////////////////////////////////////////////////////////////////////////////////
-//! Helper function for appending a child node.
-
-template<typename T>
-inline void appendChild(NodePtr parent, Core::RefCntPtr<T>& child)
-{
-	ASSERT((parent->type() == DOCUMENT_NODE) || (parent->type() == ELEMENT_NODE));
-
-	if (parent->type() == DOCUMENT_NODE)
-		Core::static_ptr_cast<Document>(parent)->appendChild(child);
-	else
-		Core::static_ptr_cast<ElementNode>(parent)->appendChild(child);
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Read a document from a string.
 
@@ -76,12 +182,131 @@ DocumentPtr Reader::parseDocument(const tstring& string, uint flags)
 
 DocumentPtr Reader::parseDocument(const tchar* begin, const tchar* end, uint flags)
 {
+	// Every node is kept with the source, or a copied span would differ.
+	if ((flags & KEEP_SOURCE) != 0)
+		flags &= ~DISCARD_FLAGS;
+
 	initialise(begin, end, flags);
 
 	DocumentPtr document(new Document);
 
-	// Start by appending to the document node.
+	if ((m_flags & BUILD_ID_INDEX) != 0)
+		document->enableIdIndex();
+
+	if ((m_flags & BUILD_NAME_INDEX) != 0)
+		document->enableNameIndex();
+
+	if ((m_flags & KEEP_SOURCE) != 0)
+		document->m_sourceText.assign(begin, end);
+
+	parseNodes(document);
+
+	return document;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a document from a pair of raw string pointers, only building the
+//! subtrees that match the expression. Each match is passed to the handler as
+//! soon as its end tag has been read. A match nested inside another is part of
+//! the outer match and is not passed separately.
+
+void Reader::readMatches(const tchar* begin, const tchar* end, const XPathExpression& expression, MatchHandler& handler, uint flags)
+{
+	XML::Reader        reader;
+	XPathStreamMatcher matcher(expression);
+
+	// The source is only kept with a whole document.
+	reader.initialise(begin, end, flags & ~KEEP_SOURCE);
+
+	reader.m_matcher = &matcher;
+	reader.m_handler = &handler;
+
+	reader.parseNodes(DocumentPtr(new Document));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a document from a string, only building the subtrees that match the
+//! expression.
+
+void Reader::readMatches(const tstring& string, const XPathExpression& expression, MatchHandler& handler, uint flags)
+{
+	const tchar* begin = nullptr;
+	const tchar* end   = nullptr;
+
+	// Get raw iterators for the string.
+	if (!string.empty())
+	{
+		begin = string.data();
+		end   = begin + string.length();
+	}
+
+	readMatches(begin, end, expression, handler, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a document from a pair of raw string pointers.
+
+DocumentPtr Reader::readDocument(const tchar* begin, const tchar* end, uint flags)
+{
+	XML::Reader reader;
+
+	return reader.parseDocument(begin, end, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a document from a string.
+
+DocumentPtr Reader::readDocument(const tstring& string, uint flags)
+{
+	XML::Reader reader;
+
+	return reader.parseDocument(string, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Initialise the internal state ready for reading.
+
+void Reader::initialise(const tchar* begin, const tchar* end, uint flags)
+{
+	m_begin   = begin;
+	m_end     = end;
+	m_current = begin;
+	m_flags   = flags;
+
+	m_matchRoot = nullptr;
+	m_rootFound = false;
+
+	while (!m_stack.empty())
+		m_stack.pop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the nodes in the text stream, appending them to the document. The
+//! parser specialised for the flags is used. When keeping the source nothing
+//! is discarded, so there is only the one parser for that.
+
+void Reader::parseNodes(const DocumentPtr& document)
+{
+	ASSERT(KEEP_SOURCE_PARSER+1 == ARRAY_SIZE(s_parsers));
+	ASSERT( ((m_flags & KEEP_SOURCE) == 0) || ((m_flags & DISCARD_FLAGS) == 0) );
+
+	const size_t index = ((m_flags & KEEP_SOURCE) != 0) ? KEEP_SOURCE_PARSER : (m_flags & DISCARD_FLAGS);
+	const Parser parser = s_parsers[index];
+
+	(this->*parser)(document);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the nodes in the text stream, appending them to the document, with
+//! the flags fixed.
+
+template<uint FLAGS>
+void Reader::parseNodes(const DocumentPtr& document)
+{
+	// Start by appending to the document node. When streaming the matches are
+	// built outside of the document.
 	m_stack.push(document);
+	m_document = (m_matcher == nullptr) ? document.get() : nullptr;
 
 	// For all nodes...
 	while (m_current != m_end)
@@ -102,15 +327,15 @@ DocumentPtr Reader::parseDocument(const tchar* begin, const tchar* end, uint fla
 
 					if (*m_current == TXT('-'))
 					{
-						readCommentTag(nodeBegin);
+						readCommentTag<FLAGS>(nodeBegin);
 					}
 					else if (*m_current == TXT('D'))
 					{
-						readDocTypeTag(nodeBegin);
+						readDocTypeTag<FLAGS>(nodeBegin);
 					}
 					else if (*m_current == TXT('['))
 					{
-						readCDataSection(nodeBegin);
+						readCDataSection<FLAGS>(nodeBegin);
 					}
 					else
 					{
@@ -125,18 +350,18 @@ DocumentPtr Reader::parseDocument(const tchar* begin, const tchar* end, uint fla
 			// A processing instruction tag?
 			else if (*m_current == TXT('?'))
 			{
-				readProcessingTag(nodeBegin);
+				readProcessingTag<FLAGS>(nodeBegin);
 			}
 			// An element tag.
 			else
 			{
-				readElementTag(nodeBegin);
+				readElementTag<FLAGS>(nodeBegin);
 			}
 		}
 		// Is text.
 		else
 		{
-			readTextNode(nodeBegin);
+			readTextNode<FLAGS>(nodeBegin);
 		}
 	}
 
@@ -147,51 +372,90 @@ DocumentPtr Reader::parseDocument(const tchar* begin, const tchar* end, uint fla
 	m_stack.pop();
 
 	// Document empty?
-	if (!document->hasRootElement())
+	if (!m_rootFound)
 		throw IOException(TXT("The XML document was empty"));
 
 	ASSERT(m_stack.size() == 0);
-
-	return document;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Read a document from a pair of raw string pointers.
+//! Append a node to the innermost open element, or the document if there is
+//! none. The node is always last in document order and the document being
+//! built is already known, so the container doesn't need to find either.
 
-DocumentPtr Reader::readDocument(const tchar* begin, const tchar* end, uint flags)
+void Reader::appendChild(const NodePtr& node)
 {
-	XML::Reader reader;
+	const NodePtr& parent = m_stack.top();
 
-	return reader.parseDocument(begin, end, flags);
+	ASSERT((parent->type() == DOCUMENT_NODE) || (parent->type() == ELEMENT_NODE));
+
+	NodeContainer::fromNode(parent.get())->appendLast(node, m_document);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Read a document from a string.
+//! Handle the start of an element. When streaming, an element outside a match
+//! is kept on the stack, but not attached to its parent, so that its end tag
+//! can be validated and it is then discarded.
 
-DocumentPtr Reader::readDocument(const tstring& string, uint flags)
+void Reader::openElement(const ElementNodePtr& node, bool empty)
 {
-	XML::Reader reader;
+	if (m_stack.size() == 1)
+		m_rootFound = true;
 
-	return reader.parseDocument(string, flags);
+	if (isBuilding())
+	{
+		appendChild(node);
+	}
+	else if (m_matcher->enterElement(*node))
+	{
+		m_matchRoot = node.get();
+	}
+
+	// Track start tags.
+	if (!empty)
+		m_stack.push(node);
+	else
+		closeElement(node);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Initialise the internal state ready for reading.
+//! Handle the end of an element. When streaming, a completed match is passed
+//! to the handler.
 
-void Reader::initialise(const tchar* begin, const tchar* end, uint flags)
+void Reader::closeElement(const NodePtr& node)
 {
-	m_begin   = begin;
-	m_end     = end;
-	m_current = begin;
-	m_flags   = flags;
+	if (m_matcher == nullptr)
+		return;
 
-	while (!m_stack.empty())
-		m_stack.pop();
+	// Inside a match?
+	if ( (m_matchRoot != nullptr) && (m_matchRoot != node.get()) )
+		return;
+
+	if (m_matchRoot == node.get())
+	{
+		m_matchRoot = nullptr;
+		m_handler->onMatch(ElementNodePtr(static_cast<ElementNode*>(node.get()), true));
+	}
+
+	m_matcher->leaveElement();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the span of the source text that a node was read from, if keeping
+//! the source, which is the text just read. This must follow linking the node
+//! in as any spans a node brings into the document are dropped.
+
+template<uint FLAGS>
+inline void Reader::recordSource(Node& node, size_t length) const
+{
+	if (isSet<FLAGS>(KEEP_SOURCE))
+		node.setSource((m_current - m_begin) - length, m_current - m_begin);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Read and parse a comment tag.
 
+template<uint FLAGS>
 void Reader::readCommentTag(const tchar* nodeBegin)
 {
 	ASSERT((m_current-nodeBegin) >= 2);
@@ -218,7 +482,7 @@ void Reader::readCommentTag(const tchar* nodeBegin)
 	}
 
 	// Keeping comments?
-	if ((m_flags & DISCARD_COMMENTS) == 0)
+	if (!isSet<FLAGS>(DISCARD_COMMENTS))
 	{
 		// Adjust iterators for the inner text.
 		nodeBegin += 4;
@@ -227,13 +491,17 @@ void Reader::readCommentTag(const tchar* nodeBegin)
 		// Create node and append to collection.
 		CommentNodePtr node = CommentNodePtr(new CommentNode(tstring(nodeBegin, nodeEnd)));
 
-		appendChild(m_stack.top(), node);
+		if (isBuilding())
+			appendChild(node);
+
+		recordSource<FLAGS>(*node, length);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Read and parse a processing instruction tag.
 
+template<uint FLAGS>
 void Reader::readProcessingTag(const tchar* nodeBegin)
 {
 	// Find node terminator.
@@ -258,18 +526,21 @@ void Reader::readProcessingTag(const tchar* nodeBegin)
 	}
 
 	// Keeping processing instructions?
-	if ((m_flags & DISCARD_PROC_INSTNS) == 0)
+	if ( (!isSet<FLAGS>(DISCARD_PROC_INSTNS)) && (isBuilding()) )
 	{
 		// Adjust iterators for the inner text.
 		nodeBegin += 2;
 		nodeEnd   -= 2;
 
-		tstring    target;
-		Attributes attributes;
+		tstring target;
 
 		// Read the target.
 		const tchar* current = readIdentifier(nodeBegin, nodeEnd, target);
 
+		// Create node, reading the attributes straight into it.
+		ProcessingNodePtr node = ProcessingNodePtr(new ProcessingNode(target));
+		Attributes&       attributes = node->getAttributes();
+
 		while (current != nodeEnd)
 		{
 			// Skip white-space.
@@ -287,16 +558,17 @@ void Reader::readProcessingTag(const tchar* nodeBegin)
 			}
 		}
 
-		// Create node and append to collection.
-		ProcessingNodePtr node = ProcessingNodePtr(new ProcessingNode(target, attributes));
+		// Append node to collection.
+		appendChild(node);
 
-		appendChild(m_stack.top(), node);
+		recordSource<FLAGS>(*node, length);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Read and create a text node.
 
+template<uint FLAGS>
 void Reader::readTextNode(const tchar* nodeBegin)
 {
 	bool whitespaceOnly = true;
@@ -320,12 +592,18 @@ void Reader::readTextNode(const tchar* nodeBegin)
 			throw IOException(TXT("Non-whitespace character(s) outside the root element"));
 
 		// Not just white-space OR we're keeping white-space?
-		if (!whitespaceOnly || ((m_flags & DISCARD_WHITESPACE) == 0))
+		if ( (!whitespaceOnly || !isSet<FLAGS>(DISCARD_WHITESPACE)) && (isBuilding()) )
 		{
+			tstring text;
+
+			decodeValue(nodeBegin, nodeEnd, text);
+
 			// Create node and append to collection.
-			TextNodePtr node = TextNodePtr(new TextNode(tstring(nodeBegin, nodeEnd)));
+			TextNodePtr node = TextNodePtr(new TextNode(text));
 
-			appendChild(m_stack.top(), node);
+			appendChild(node);
+
+			recordSource<FLAGS>(*node, nodeEnd - nodeBegin);
 		}
 	}
 }
@@ -334,6 +612,7 @@ void Reader::readTextNode(const tchar* nodeBegin)
 //! Read and parse an element tag. If the tag is a start tag or empty tag an
 //! element node is returned. If it's a close tag, no node is returned.
 
+template<uint FLAGS>
 void Reader::readElementTag(const tchar* nodeBegin)
 {
 	// Find node terminator.
@@ -392,18 +671,25 @@ void Reader::readElementTag(const tchar* nodeBegin)
 		ASSERT(!m_stack.empty());
 
 		// Validate tag matches the last open one.
-		NodePtr node = m_stack.top();
+		const NodePtr& node = m_stack.top();
 
 		if (node->type() != ELEMENT_NODE)
 			throw IOException(TXT("End tag encountered without a matching start tag"));
 
-		ElementNodePtr element = Core::static_ptr_cast<ElementNode>(node);
+		const ElementNode* element = static_cast<const ElementNode*>(node.get());
 
 		if (element->name() != name)
 			throw IOException(TXT("End tag does not match the last start tag"));
 
 		// Valid.
+		NodePtr closed = node;
+
+		// The span runs from the start tag, which is all that's left of it.
+		if (isSet<FLAGS>(KEEP_SOURCE))
+			closed->setSource(closed->m_sourceBegin, m_current - m_begin);
+
 		m_stack.pop();
+		closeElement(closed);
 	}
 	// Is an open or empty element.
 	else
@@ -416,12 +702,15 @@ void Reader::readElementTag(const tchar* nodeBegin)
 		else
 			nodeEnd -= 1;
 
-		tstring    elementName;
-		Attributes attributes;
+		tstring elementName;
 
 		// Read the target.
 		const tchar* current = readIdentifier(nodeBegin, nodeEnd, elementName);
 
+		// Create node, reading the attributes straight into it.
+		ElementNodePtr node(new ElementNode(elementName));
+		Attributes&    attributes = node->getAttributes();
+
 		while (current != nodeEnd)
 		{
 			// Skip white-space.
@@ -439,20 +728,22 @@ void Reader::readElementTag(const tchar* nodeBegin)
 			}
 		}
 
-		// Create node and append to collection.
-		ElementNodePtr node(new ElementNode(elementName, attributes));
-
-		appendChild(m_stack.top(), node);
+		openElement(node, (*nodeEnd == TXT('/')));
 
-		// Track start tags.
-		if (*nodeEnd != TXT('/'))
-			m_stack.push(node);
+		// The span is recorded once linked in and is completed by the end tag,
+		// if there is one.
+		if (isSet<FLAGS>(KEEP_SOURCE))
+		{
+			recordSource<FLAGS>(*node, length);
+			node->m_startTagEnd = m_current - m_begin;
+		}
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Read and parse a document type tag.
 
+template<uint FLAGS>
 void Reader::readDocTypeTag(const tchar* nodeBegin)
 {
 	// Find node terminator.
@@ -492,7 +783,7 @@ void Reader::readDocTypeTag(const tchar* nodeBegin)
 	}
 
 	// Keeping document type declarations?
-	if ((m_flags & DISCARD_DOC_TYPES) == 0)
+	if ( (!isSet<FLAGS>(DISCARD_DOC_TYPES)) && (isBuilding()) )
 	{
 		// Adjust iterators for the inner text.
 		nodeBegin += 9;
@@ -501,13 +792,16 @@ void Reader::readDocTypeTag(const tchar* nodeBegin)
 		// Create node and append to collection.
 		DocTypeNodePtr node = DocTypeNodePtr(new DocTypeNode(tstring(nodeBegin, nodeEnd)));
 
-		appendChild(m_stack.top(), node);
+		appendChild(node);
+
+		recordSource<FLAGS>(*node, length);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Read and parse CDATA section.
 
+template<uint FLAGS>
 void Reader::readCDataSection(const tchar* nodeBegin)
 {
 	ASSERT((m_current-nodeBegin) >= 2);
@@ -540,7 +834,10 @@ void Reader::readCDataSection(const tchar* nodeBegin)
 	// Create node and append to collection.
 	CDataNodePtr node = CDataNodePtr(new CDataNode(tstring(nodeBegin, nodeEnd)));
 
-	appendChild(m_stack.top(), node);
+	if (isBuilding())
+		appendChild(node);
+
+	recordSource<FLAGS>(*node, length);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -617,8 +914,8 @@ const tchar* Reader::readAttribute(const tchar* begin, const tchar* end, tstring
 	if ( (current == end) || (*current != quote) )
 		throw IOException(TXT("EOF encountered reading an attribute value"));
 
-	// Extract attribute name.
-	value = tstring(begin, current);
+	// Extract attribute value.
+	decodeValue(begin, current, value);
 
 	++current;
 
@@ -17,8 +17,27 @@
 namespace XML
 {
 
+// Forward declarations.
+class XPathExpression;
+class XPathStreamMatcher;
+
 ////////////////////////////////////////////////////////////////////////////////
 //! The reader to parse an XML document from a text stream.
+//!
+//! Instead of building the entire document the reader can also stream it,
+//! only building those subtrees that match an XPath expression and handing
+//! each one to a callback as soon as its end tag has been read. Memory use is
+//! then bounded by the size of the largest match, rather than the document.
+//!
+//! The flags that discard nodes, or keep the source, are checked for every
+//! node read, and so the parser is specialised for each combination of them,
+//! with the flags fixed at compile time. The specialisation is chosen once per
+//! document.
+//!
+//! When the source text is kept each node records its span of the text, so
+//! that the Writer can copy the unmodified nodes rather than regenerate them.
+//! A copied span includes any nodes within it, so the flags that discard nodes
+//! are ignored when keeping the source.
 
 class Reader /*: private NotCopyable*/
 {
@@ -31,6 +50,23 @@ public:
 		DISCARD_COMMENTS	= 0x0002,	//!< Discard comment nodes.
 		DISCARD_PROC_INSTNS	= 0x0004,	//!< Discard processing instructions.
 		DISCARD_DOC_TYPES	= 0x0008,	//!< Discard document type declarations.
+		BUILD_ID_INDEX		= 0x0010,	//!< Index the elements by ID attribute whilst reading.
+		BUILD_NAME_INDEX	= 0x0020,	//!< Index the elements by name whilst reading.
+		KEEP_SOURCE			= 0x0040,	//!< Keep the source text so that unmodified nodes can be rewritten verbatim.
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The interface for the callback that receives the matches when streaming.
+
+	class MatchHandler
+	{
+	public:
+		//! Handle an element that matched, along with its subtree.
+		virtual void onMatch(const ElementNodePtr& element) = 0;
+
+	protected:
+		//! Destructor.
+		virtual ~MatchHandler() {}
 	};
 
 	//
@@ -43,9 +79,26 @@ public:
 	//! Read a document from a string.
 	static DocumentPtr readDocument(const tstring& string, uint flags = DEFAULT); // throw(IOException)
 
+	//! Read a document from a pair of raw string pointers, only building the matches.
+	static void readMatches(const tchar* begin, const tchar* end, const XPathExpression& expression, MatchHandler& handler, uint flags = DEFAULT); // throw(IOException, InvalidArgException)
+
+	//! Read a document from a string, only building the matches.
+	static void readMatches(const tstring& string, const XPathExpression& expression, MatchHandler& handler, uint flags = DEFAULT); // throw(IOException, InvalidArgException)
+
 private:
 	//! A stack of XML nodes.
 	typedef std::stack<NodePtr> NodeStack;
+	//! The type of a specialised parser.
+	typedef void (Reader::*Parser)(const DocumentPtr&);
+
+	//! The flags that discard nodes.
+	static const uint DISCARD_FLAGS = DISCARD_WHITESPACE | DISCARD_COMMENTS | DISCARD_PROC_INSTNS | DISCARD_DOC_TYPES;
+	//! The index of the parser that keeps the source, which discards nothing.
+	static const size_t KEEP_SOURCE_PARSER = DISCARD_FLAGS+1;
+
+	//! The parsers specialised for each combination of the discard flags, and
+	//! for keeping the source.
+	static const Parser s_parsers[KEEP_SOURCE_PARSER+1];
 
 	//
 	// Members.
@@ -55,6 +108,11 @@ private:
 	const tchar*	m_current;		//!< The current position in the stream.
 	uint			m_flags;		//!< The flags to control reading.
 	NodeStack		m_stack;		//!< The stack of unclosed element nodes.
+	XPathStreamMatcher*	m_matcher;	//!< The matcher used when streaming.
+	MatchHandler*	m_handler;		//!< The handler for the matches when streaming.
+	const Node*		m_matchRoot;	//!< The root of the match being built.
+	bool			m_rootFound;	//!< Has the root element been read?
+	Document*		m_document;		//!< The document being built, unless streaming.
 
 	//
 	// Internal methods.
@@ -75,22 +133,55 @@ private:
 	//! Initialise the internal state ready for reading.
 	void initialise(const tchar* begin, const tchar* end, uint flags);
 
+	//! Parse the nodes in the text stream.
+	void parseNodes(const DocumentPtr& document); // throw(IOException)
+
+	//! Parse the nodes in the text stream with the flags fixed.
+	template<uint FLAGS>
+	void parseNodes(const DocumentPtr& document); // throw(IOException)
+
+	//! Query if a flag is set in a fixed set of flags.
+	template<uint FLAGS>
+	static bool isSet(uint flag);
+
+	//! Query if the nodes being read are kept.
+	bool isBuilding() const;
+
+	//! Append a node to the innermost open element.
+	void appendChild(const NodePtr& node);
+
+	//! Handle the start of an element.
+	void openElement(const ElementNodePtr& node, bool empty);
+
+	//! Handle the end of an element.
+	void closeElement(const NodePtr& node);
+
+	//! Record the span of the source text that a node was read from.
+	template<uint FLAGS>
+	void recordSource(Node& node, size_t length) const;
+
 	//! Read and parse a comment tag.
+	template<uint FLAGS>
 	void readCommentTag(const tchar* nodeBegin);
 
 	//! Read and parse a processing instruction tag.
+	template<uint FLAGS>
 	void readProcessingTag(const tchar* nodeBegin);
 
 	//! Read and create a text node.
+	template<uint FLAGS>
 	void readTextNode(const tchar* nodeBegin);
 
 	//! Read and parse an element tag.
+	template<uint FLAGS>
 	void readElementTag(const tchar* nodeBegin);
 
 	//! Read and parse a document type tag.
+	template<uint FLAGS>
 	void readDocTypeTag(const tchar* nodeBegin);
 
 	//! Read and parse CDATA section.
+	template<uint FLAGS>
 	void readCDataSection(const tchar* nodeBegin);
 
 	//! Read an identifier.
@@ -104,6 +195,25 @@ private:
 	Reader& operator=(const Reader);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a flag is set in a fixed set of flags, which the compiler resolves
+//! at compile time.
+
+template<uint FLAGS>
+inline bool Reader::isSet(uint flag)
+{
+	return ((FLAGS & flag) != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the nodes being read are kept, which is always the case unless
+//! streaming and outside a match.
+
+inline bool Reader::isBuilding() const
+{
+	return ( (m_matcher == nullptr) || (m_matchRoot != nullptr) );
+}
+
 //namespace XML
 }
 
@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StreamSink.cpp
+//! \brief  The StreamSink class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "StreamSink.hpp"
+#include "IOException.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from an output stream.
+
+StreamSink::StreamSink(Stream& stream)
+	: m_stream(stream)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+StreamSink::~StreamSink()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a chunk of text to the stream.
+
+void StreamSink::write(const tchar* text, size_t length)
+{
+	m_stream.write(text, static_cast<std::streamsize>(length));
+
+	if (m_stream.fail())
+		throw IOException(TXT("Failed to write the XML to the output stream"));
+}
+
+//namespace XML
+}
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StreamSink.hpp
+//! \brief  The StreamSink class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_STREAMSINK_HPP
+#define XML_STREAMSINK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "OutputSink.hpp"
+#include <ostream>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The sink used to write the output to a standard library output stream. The
+//! stream is not owned by the sink and is not flushed.
+
+class StreamSink : public OutputSink /*, private NotCopyable*/
+{
+public:
+	//! The type of stream written to.
+	typedef std::basic_ostream<tchar> Stream;
+
+	//! Construction from an output stream.
+	explicit StreamSink(Stream& stream);
+
+	//! Destructor.
+	virtual ~StreamSink();
+
+	//
+	// Methods.
+	//
+
+	//! Write a chunk of text to the stream.
+	virtual void write(const tchar* text, size_t length); // throw(IOException)
+
+private:
+	//
+	// Members.
+	//
+	Stream&	m_stream;	//!< The stream to write to.
+
+	// NotCopyable.
+	StreamSink(const StreamSink&);
+	StreamSink& operator=(const StreamSink);
+};
+
+//namespace XML
+}
+
+#endif // XML_STREAMSINK_HPP
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StreamWriter.cpp
+//! \brief  The StreamWriter class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "StreamWriter.hpp"
+#include <Core/BadLogicException.hpp>
+#include <Core/StringUtils.hpp>
+#include <algorithm>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from the sink to write to and the formatting options. The sink
+//! must outlive the writer.
+
+StreamWriter::StreamWriter(OutputSink& sink, uint flags, const tchar* indentStyle)
+	: m_output(((flags & Writer::NO_FORMATTING) == 0), indentStyle, Writer::DEFAULT_TERMINATOR)
+	, m_open()
+	, m_attributes()
+	, m_rootWritten(false)
+{
+	m_output.attach(sink, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any output not written by endDocument() is discarded.
+
+StreamWriter::~StreamWriter()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start an element, which is either the root element or a child of the last
+//! element started.
+
+void StreamWriter::startElement(const tstring& name)
+{
+	if (m_open.empty())
+	{
+		if (m_rootWritten)
+			throw Core::BadLogicException(TXT("The document already has a root element"));
+
+		m_rootWritten = true;
+	}
+	else
+	{
+		beginContent(NODE_CONTENT);
+	}
+
+	m_output.writeIndentation(m_open.size());
+	m_output.write(TXT("<"), 1);
+	m_output.write(name);
+
+	OpenElement element = { name, NO_CONTENT };
+
+	m_open.push_back(element);
+	m_attributes.clear();
+
+	m_output.flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add an attribute to the element just started, which must be before any of
+//! its content has been written. An element can't have two attributes with
+//! the same name.
+
+void StreamWriter::attribute(const tstring& name, const tstring& value)
+{
+	if ( (m_open.empty()) || (m_open.back().m_content != NO_CONTENT) )
+		throw Core::BadLogicException(TXT("An attribute can only be written after the start of an element"));
+
+	if (std::find(m_attributes.begin(), m_attributes.end(), name) != m_attributes.end())
+		throw Core::BadLogicException(Core::fmt(TXT("The attribute '%s' has already been written"), name.c_str()));
+
+	m_attributes.push_back(name);
+
+	m_output.write(TXT(" "), 1);
+	m_output.write(name);
+	m_output.write(TXT("=\""), 2);
+	m_output.writeEscaped(value, true);
+	m_output.write(TXT("\""), 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a text value within the last element started.
+
+void StreamWriter::text(const tstring& text_)
+{
+	if (m_open.empty())
+		throw Core::BadLogicException(TXT("Text can only be written within an element"));
+
+	beginContent(TEXT_CONTENT);
+	m_output.writeEscaped(text_, false);
+	m_output.flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a CDATA section within the last element started. As a section can't
+//! contain its own terminator, any "]]>" in the text is split across two
+//! sections.
+
+void StreamWriter::cdata(const tstring& text_)
+{
+	if (m_open.empty())
+		throw Core::BadLogicException(TXT("A CDATA section can only be written within an element"));
+
+	beginContent(TEXT_CONTENT);
+
+	size_t begin = 0;
+	size_t end = text_.find(TXT("]]>"));
+
+	m_output.write(TXT("<![CDATA["), 9);
+
+	while (end != tstring::npos)
+	{
+		m_output.write(text_.data()+begin, end+2-begin);
+		m_output.write(TXT("]]><![CDATA["), 12);
+
+		begin = end+2;
+		end = text_.find(TXT("]]>"), begin);
+	}
+
+	m_output.write(text_.data()+begin, text_.length()-begin);
+	m_output.write(TXT("]]>"), 3);
+	m_output.flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a comment, either within the last element started or outside the
+//! root element. A comment can't contain "--" or end with a '-'.
+
+void StreamWriter::comment(const tstring& comment_)
+{
+	if ( (comment_.find(TXT("--")) != tstring::npos)
+	  || ((!comment_.empty()) && (comment_[comment_.length()-1] == TXT('-'))) )
+	{
+		throw Core::BadLogicException(TXT("A comment can't contain '--' or end with '-'"));
+	}
+
+	if (!m_open.empty())
+		beginContent(NODE_CONTENT);
+
+	m_output.writeIndentation(m_open.size());
+	m_output.write(TXT("<!--"), 4);
+	m_output.write(comment_);
+	m_output.write(TXT("-->"), 3);
+	m_output.writeTerminator();
+	m_output.flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! End the last element started. An element with no content is written as an
+//! empty tag.
+
+void StreamWriter::endElement()
+{
+	if (m_open.empty())
+		throw Core::BadLogicException(TXT("There is no open element to end"));
+
+	const OpenElement& element = m_open.back();
+
+	if (element.m_content == NO_CONTENT)
+	{
+		m_output.write(TXT("/>"), 2);
+	}
+	else
+	{
+		if (element.m_content == NODE_CONTENT)
+			m_output.writeIndentation(m_open.size()-1);
+
+		m_output.write(TXT("</"), 2);
+		m_output.write(element.m_name);
+		m_output.write(TXT(">"), 1);
+	}
+
+	m_output.writeTerminator();
+	m_open.pop_back();
+	m_output.flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! End the document, which must have no open elements, and write any buffered
+//! output to the sink.
+
+void StreamWriter::endDocument()
+{
+	if (!m_open.empty())
+		throw Core::BadLogicException(Core::fmt(TXT("The element '%s' has not been ended"), m_open.back().m_name.c_str()));
+
+	m_output.flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Prepare the open element for some content, by closing its start tag. When
+//! a child node follows text the rest of the content is written on its own
+//! lines, so the text is left inline.
+
+void StreamWriter::beginContent(Content content)
+{
+	ASSERT(!m_open.empty());
+	ASSERT(content != NO_CONTENT);
+
+	OpenElement& element = m_open.back();
+
+	if (element.m_content == NO_CONTENT)
+		m_output.write(TXT(">"), 1);
+
+	if ( (content == NODE_CONTENT) && (element.m_content != NODE_CONTENT) )
+	{
+		m_output.writeTerminator();
+		element.m_content = NODE_CONTENT;
+	}
+	else if (element.m_content == NO_CONTENT)
+	{
+		element.m_content = content;
+	}
+}
+
+//namespace XML
+}
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StreamWriter.hpp
+//! \brief  The StreamWriter class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_STREAMWRITER_HPP
+#define XML_STREAMWRITER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Writer.hpp"
+#include "OutputBuffer.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The writer used to create XML directly from a sequence of calls, rather than
+//! from a document. The markup is written to the sink as the calls are made,
+//! so no nodes are created and the memory used is bounded by the buffer size
+//! and the depth of the open elements.
+//!
+//! The open elements are tracked so that the output is always well formed,
+//! and any call that would break that throws. The escaping and formatting are
+//! the same as the Writer, except that an element whose content starts with
+//! text is assumed to only contain text.
+
+class StreamWriter /*: private NotCopyable*/
+{
+public:
+	//! Construction from the sink to write to and the formatting options.
+	StreamWriter(OutputSink& sink, uint flags = Writer::DEFAULT, const tchar* indentStyle = Writer::DEFAULT_INDENT_STYLE);
+
+	//! Destructor.
+	~StreamWriter();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of open elements.
+	size_t depth() const;
+
+	//
+	// Methods.
+	//
+
+	//! Start an element.
+	void startElement(const tstring& name); // throw(BadLogicException, IOException)
+
+	//! Add an attribute to the element just started.
+	void attribute(const tstring& name, const tstring& value); // throw(BadLogicException)
+
+	//! Write a text value.
+	void text(const tstring& text); // throw(BadLogicException, IOException)
+
+	//! Write a CDATA section.
+	void cdata(const tstring& text); // throw(BadLogicException, IOException)
+
+	//! Write a comment.
+	void comment(const tstring& comment); // throw(BadLogicException, IOException)
+
+	//! End the last element started.
+	void endElement(); // throw(BadLogicException, IOException)
+
+	//! End the document and write any buffered output to the sink.
+	void endDocument(); // throw(BadLogicException, IOException)
+
+private:
+	//! The content of an open element written so far.
+	enum Content
+	{
+		NO_CONTENT,		//!< Nothing, so the start tag is still open.
+		TEXT_CONTENT,	//!< Only text, which is written inline.
+		NODE_CONTENT,	//!< Child nodes, which are written on their own lines.
+	};
+
+	//! An element that has been started but not ended.
+	struct OpenElement
+	{
+		tstring		m_name;		//!< The element name.
+		Content		m_content;	//!< The content written so far.
+	};
+
+	//! The stack of open elements.
+	typedef std::vector<OpenElement> OpenElements;
+	//! The names of the attributes written for an element.
+	typedef std::vector<tstring> AttributeNames;
+
+	//
+	// Members.
+	//
+	OutputBuffer	m_output;		//!< The output buffer.
+	OpenElements	m_open;			//!< The open elements.
+	AttributeNames	m_attributes;	//!< The attributes of the element just started.
+	bool			m_rootWritten;	//!< Has the root element been started?
+
+	//
+	// Internal methods.
+	//
+
+	//! Prepare the open element for some content.
+	void beginContent(Content content);
+
+	// NotCopyable.
+	StreamWriter(const StreamWriter&);
+	StreamWriter& operator=(const StreamWriter);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of open elements.
+
+inline size_t StreamWriter::depth() const
+{
+	return m_open.size();
+}
+
+//namespace XML
+}
+
+#endif // XML_STREAMWRITER_HPP
@@ -0,0 +1,297 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StringMap.hpp
+//! \brief  The StringMap class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_STRINGMAP_HPP
+#define XML_STRINGMAP_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <vector>
+#include <algorithm>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A hash table keyed by string, used for the document's indexes so that a
+//! lookup is O(1) on average rather than the O(log n) of a std::map. Each
+//! bucket is a vector of entries and the number of buckets is doubled whenever
+//! the table becomes fuller than one entry per bucket. The entries are
+//! unordered, so there is no iteration. A reference to a value is only valid
+//! until the next key is added.
+
+template<typename T>
+class StringMap
+{
+public:
+	//! Default constructor.
+	StringMap();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the map is empty.
+	bool isEmpty() const;
+
+	//! Query how many entries there are.
+	size_t count() const;
+
+	//
+	// Methods.
+	//
+
+	//! Find the value for a key, if present.
+	const T* find(const tstring& key) const;
+
+	//! Find the value for a key, if present.
+	T* find(const tstring& key);
+
+	//! Get the value for a key, adding a default value if not present.
+	T& operator[](const tstring& key);
+
+	//! Remove the entry for a key, if present.
+	bool erase(const tstring& key);
+
+	//! Remove all the entries.
+	void clear();
+
+private:
+	//! An entry in a bucket.
+	struct Entry
+	{
+		size_t	m_hash;		//!< The hash of the key.
+		tstring	m_key;		//!< The key.
+		T		m_value;	//!< The value.
+	};
+
+	//! A bucket of entries whose keys share a hash slot.
+	typedef std::vector<Entry> Bucket;
+	//! The table of buckets.
+	typedef std::vector<Bucket> Buckets;
+
+	//! The number of buckets the table starts with.
+	static const size_t INITIAL_BUCKETS = 16;
+
+	//
+	// Members.
+	//
+	Buckets	m_buckets;	//!< The buckets, which number a power of 2.
+	size_t	m_count;	//!< The number of entries.
+
+	//
+	// Internal methods.
+	//
+
+	//! Find the entry for a key, if present.
+	const Entry* findEntry(const tstring& key, size_t hash) const;
+
+	//! Double the number of buckets.
+	void grow();
+
+	//
+	// Class methods.
+	//
+
+	//! Calculate the hash of a key.
+	static size_t hash(const tstring& key);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor. The buckets are only allocated when the first entry is
+//! added.
+
+template<typename T>
+inline StringMap<T>::StringMap()
+	: m_buckets()
+	, m_count(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the map is empty.
+
+template<typename T>
+inline bool StringMap<T>::isEmpty() const
+{
+	return (m_count == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query how many entries there are.
+
+template<typename T>
+inline size_t StringMap<T>::count() const
+{
+	return m_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the value for a key, if present.
+
+template<typename T>
+inline const T* StringMap<T>::find(const tstring& key) const
+{
+	const Entry* entry = findEntry(key, hash(key));
+
+	return (entry != nullptr) ? &entry->m_value : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the value for a key, if present.
+
+template<typename T>
+inline T* StringMap<T>::find(const tstring& key)
+{
+	const Entry* entry = findEntry(key, hash(key));
+
+	return (entry != nullptr) ? const_cast<T*>(&entry->m_value) : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value for a key, adding a default value if not present.
+
+template<typename T>
+T& StringMap<T>::operator[](const tstring& key)
+{
+	const size_t keyHash = hash(key);
+	const Entry* entry = findEntry(key, keyHash);
+
+	if (entry != nullptr)
+		return const_cast<T&>(entry->m_value);
+
+	if (m_count >= m_buckets.size())
+		grow();
+
+	Bucket& bucket = m_buckets[keyHash & (m_buckets.size()-1)];
+
+	bucket.push_back(Entry());
+
+	Entry& added = bucket.back();
+
+	added.m_hash = keyHash;
+	added.m_key = key;
+	++m_count;
+
+	return added.m_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the entry for a key, if present. The order of the entries within a
+//! bucket doesn't matter, so the last one is moved into the hole.
+
+template<typename T>
+bool StringMap<T>::erase(const tstring& key)
+{
+	if (m_count == 0)
+		return false;
+
+	const size_t keyHash = hash(key);
+	Bucket&      bucket = m_buckets[keyHash & (m_buckets.size()-1)];
+
+	for (typename Bucket::iterator it = bucket.begin(); it != bucket.end(); ++it)
+	{
+		if ( (it->m_hash == keyHash) && (it->m_key == key) )
+		{
+			if (&*it != &bucket.back())
+			{
+				it->m_hash = bucket.back().m_hash;
+				it->m_key.swap(bucket.back().m_key);
+				std::swap(it->m_value, bucket.back().m_value);
+			}
+
+			bucket.pop_back();
+			--m_count;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all the entries. The buckets are kept for reuse.
+
+template<typename T>
+void StringMap<T>::clear()
+{
+	for (typename Buckets::iterator it = m_buckets.begin(); it != m_buckets.end(); ++it)
+		it->clear();
+
+	m_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the entry for a key, if present.
+
+template<typename T>
+const typename StringMap<T>::Entry* StringMap<T>::findEntry(const tstring& key, size_t keyHash) const
+{
+	if (m_count == 0)
+		return nullptr;
+
+	const Bucket& bucket = m_buckets[keyHash & (m_buckets.size()-1)];
+
+	for (typename Bucket::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+	{
+		if ( (it->m_hash == keyHash) && (it->m_key == key) )
+			return &*it;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Double the number of buckets. The entries are swapped into their new
+//! buckets, rather than copied.
+
+template<typename T>
+void StringMap<T>::grow()
+{
+	Buckets buckets(m_buckets.empty() ? INITIAL_BUCKETS : (m_buckets.size() * 2));
+
+	const size_t mask = buckets.size() - 1;
+
+	for (typename Buckets::iterator bucket = m_buckets.begin(); bucket != m_buckets.end(); ++bucket)
+	{
+		for (typename Bucket::iterator it = bucket->begin(); it != bucket->end(); ++it)
+		{
+			Bucket& target = buckets[it->m_hash & mask];
+
+			target.push_back(Entry());
+
+			Entry& moved = target.back();
+
+			moved.m_hash = it->m_hash;
+			moved.m_key.swap(it->m_key);
+			std::swap(moved.m_value, it->m_value);
+		}
+	}
+
+	m_buckets.swap(buckets);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the hash of a key using FNV-1a, one character at a time.
+
+template<typename T>
+inline size_t StringMap<T>::hash(const tstring& key)
+{
+	size_t value = 2166136261u;
+
+	for (tstring::const_iterator it = key.begin(); it != key.end(); ++it)
+		value = (value ^ static_cast<size_t>(*it)) * 16777619u;
+
+	return value;
+}
+
+//namespace XML
+}
+
+#endif // XML_STRINGMAP_HPP
@@ -100,6 +100,62 @@ TEST_CASE("modifying the value of an attribute modifies the sequence")
 }
 TEST_CASE_END
 
+TEST_CASE("a copy of the collection holds its own attributes")
+{
+	XML::Attributes original;
+
+	original.set(TXT("name"), TXT("original"));
+
+	XML::Attributes copy(original);
+
+	copy.find(TXT("name"))->setValue(TXT("copy"));
+
+	TEST_TRUE(original.getValue(TXT("name")) == TXT("original"));
+	TEST_TRUE(copy.getValue(TXT("name")) == TXT("copy"));
+
+	XML::Attributes assigned;
+
+	assigned = original;
+	assigned.set(TXT("name"), TXT("assigned"));
+
+	TEST_TRUE(original.getValue(TXT("name")) == TXT("original"));
+}
+TEST_CASE_END
+
+TEST_CASE("an attribute belonging to another collection is copied when set")
+{
+	XML::Attributes first;
+	XML::Attributes second;
+
+	first.set(TXT("name"), TXT("value"));
+	second.set(first.get(TXT("name")));
+
+	TEST_TRUE(second.get(TXT("name")) != first.get(TXT("name")));
+
+	second.get(TXT("name"))->setValue(TXT("changed"));
+
+	TEST_TRUE(first.getValue(TXT("name")) == TXT("value"));
+}
+TEST_CASE_END
+
+TEST_CASE("an attribute can outlive the collection it belonged to")
+{
+	XML::AttributePtr attribute;
+
+	{
+		XML::Attributes attributes;
+
+		attributes.set(TXT("name"), TXT("value"));
+
+		attribute = attributes.get(TXT("name"));
+	}
+
+	attribute->setValue(TXT("changed"));
+
+	TEST_TRUE(attribute->value() == TXT("changed"));
+}
+TEST_CASE_END
+
 TEST_CASE("an attribute can be searched for by its name")
 {
 	XML::Attributes attributes;
@@ -64,7 +64,7 @@ TEST_CASE("appending a child node creates a non-empty node sequence")
 
 	TEST_TRUE((*firstChild).get() == textNode.get());
 
-	XML::Nodes::iterator endChild = document->endChild();	// ++pDoc->BeginChild() fails to build in Release.
+	XML::NodeContainer::iterator endChild = document->endChild();	// ++pDoc->BeginChild() fails to build in Release.
 
 	TEST_TRUE(++firstChild == endChild);
 }
@@ -119,5 +119,421 @@ TEST_CASE("a document with a root element can be made via a helper")
 }
 TEST_CASE_END
 
+TEST_CASE("the root element can be accessed without taking a reference")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	TEST_TRUE(document->rootElement() == root.get());
+
+	const XML::DocumentPtr constDocument = document;
+
+	TEST_TRUE(constDocument->rootElement() == root.get());
+}
+TEST_CASE_END
+
+TEST_CASE("the root element is the first element even when one is inserted before it")
+{
+	XML::DocumentPtr document(new XML::Document);
+	XML::TextNodePtr textNode(new XML::TextNode(TXT("TextNode")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("second")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("first")));
+
+	document->appendChild(textNode);
+	document->appendChild(second);
+
+	TEST_TRUE(document->getRootElement() == second);
+
+	document->insertChild(first, textNode);
+
+	TEST_TRUE(document->getRootElement() == first);
+}
+TEST_CASE_END
+
+TEST_CASE("removing the root element from a document removes the root element")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->removeChild(root);
+
+	TEST_TRUE(document->hasRootElement() == false);
+	TEST_TRUE(document->rootElement() == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("an element can be found by the value of its ID attribute")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr child(new XML::ElementNode(TXT("child")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	child->setAttribute(TXT("id"), TXT("42"));
+	root->appendChild(child);
+
+	TEST_TRUE(document->getElementById(TXT("42")) == child);
+	TEST_TRUE(document->hasIdIndex());
+}
+TEST_CASE_END
+
+TEST_CASE("finding an element by an unknown ID returns an empty pointer")
+{
+	XML::DocumentPtr document(new XML::Document(XML::makeElement(TXT("root"))));
+
+	TEST_TRUE(document->getElementById(TXT("42")).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("the ID index is updated when elements are appended or removed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr child(new XML::ElementNode(TXT("child")));
+	XML::ElementNodePtr grandchild(new XML::ElementNode(TXT("grandchild")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableIdIndex();
+
+	grandchild->setAttribute(TXT("id"), TXT("2"));
+	child->appendChild(grandchild);
+	root->appendChild(child);
+
+	TEST_TRUE(document->getElementById(TXT("2")) == grandchild);
+
+	root->removeChild(child);
+
+	TEST_TRUE(document->getElementById(TXT("2")).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("the ID index is updated when an ID attribute is set")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableIdIndex();
+
+	root->setAttribute(TXT("id"), TXT("1"));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == root);
+
+	root->setAttribute(TXT("id"), TXT("2"));
+
+	TEST_TRUE(document->getElementById(TXT("1")).empty());
+	TEST_TRUE(document->getElementById(TXT("2")) == root);
+}
+TEST_CASE_END
+
+TEST_CASE("the first element in document order is found when an ID is duplicated")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("first")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("second")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableIdIndex();
+
+	second->setAttribute(TXT("id"), TXT("1"));
+	root->appendChild(second);
+	first->setAttribute(TXT("id"), TXT("1"));
+	root->insertChild(first, second);
+
+	TEST_TRUE(document->getElementById(TXT("1")) == first);
+
+	root->removeChild(first);
+
+	TEST_TRUE(document->getElementById(TXT("1")) == second);
+}
+TEST_CASE_END
+
+TEST_CASE("the first element in document order is found when a duplicate ID is inserted after another is shadowed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr before(new XML::ElementNode(TXT("before")));
+	XML::ElementNodePtr after(new XML::ElementNode(TXT("after")));
+	XML::ElementNodePtr inserted(new XML::ElementNode(TXT("inserted")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableIdIndex();
+
+	after->setAttribute(TXT("id"), TXT("2"));
+	root->appendChild(after);
+	root->appendChild(XML::makeElement(TXT("first"), XML::makeAttribute(TXT("id"), TXT("1"))));
+	root->appendChild(XML::makeElement(TXT("second"), XML::makeAttribute(TXT("id"), TXT("1"))));
+
+	TEST_TRUE(document->getElementById(TXT("2")) == after);
+
+	inserted->setAttribute(TXT("id"), TXT("2"));
+	root->insertChild(inserted, after);
+
+	TEST_TRUE(document->getElementById(TXT("2")) == inserted);
+}
+TEST_CASE_END
+
+TEST_CASE("the first element in document order is found when a duplicate ID is set on an earlier element")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr parent(new XML::ElementNode(TXT("parent")));
+	XML::ElementNodePtr nested(new XML::ElementNode(TXT("nested")));
+	XML::ElementNodePtr later(new XML::ElementNode(TXT("later")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	root->appendChild(parent);
+	parent->appendChild(nested);
+	root->appendChild(later);
+	later->setAttribute(TXT("id"), TXT("1"));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == later);
+
+	nested->getAttributes() = XML::Attributes(XML::makeAttribute(TXT("id"), TXT("1")));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == nested);
+
+	nested->getAttributes().clear();
+
+	TEST_TRUE(document->getElementById(TXT("1")) == later);
+
+	root->setAttribute(TXT("id"), TXT("1"));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == root);
+}
+TEST_CASE_END
+
+TEST_CASE("the ID index is updated when the attributes are changed directly")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableIdIndex();
+
+	root->getAttributes().set(TXT("id"), TXT("1"));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == root);
+
+	root->getAttributes().set(XML::makeAttribute(TXT("id"), TXT("2")));
+
+	TEST_TRUE(document->getElementById(TXT("1")).empty());
+	TEST_TRUE(document->getElementById(TXT("2")) == root);
+
+	root->getAttributes().clear();
+
+	TEST_TRUE(document->getElementById(TXT("2")).empty());
+
+	root->getAttributes() = XML::Attributes(XML::makeAttribute(TXT("id"), TXT("3")));
+
+	TEST_TRUE(document->getElementById(TXT("3")) == root);
+}
+TEST_CASE_END
+
+TEST_CASE("all elements with a name can be found in document order")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("item")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("item")));
+	XML::ElementNodePtr nested(new XML::ElementNode(TXT("item")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	root->appendChild(first);
+	root->appendChild(second);
+	first->appendChild(nested);
+
+	const XML::Document::Elements& elements = document->elementsByName(TXT("item"));
+
+	TEST_TRUE(document->hasNameIndex());
+	TEST_TRUE(elements.size() == 3);
+	TEST_TRUE(elements[0] == first.get());
+	TEST_TRUE(elements[1] == nested.get());
+	TEST_TRUE(elements[2] == second.get());
+	TEST_TRUE(document->elementsByName(TXT("unknown")).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("the name index is updated when elements are appended or removed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("item")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("item")));
+	XML::ElementNodePtr nested(new XML::ElementNode(TXT("item")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableNameIndex();
+
+	root->appendChild(first);
+	root->appendChild(second);
+
+	TEST_TRUE(document->elementsByName(TXT("item")).size() == 2);
+
+	first->appendChild(nested);
+
+	TEST_TRUE(document->elementsByName(TXT("item"))[1] == nested.get());
+
+	root->removeChild(first);
+
+	TEST_TRUE(document->elementsByName(TXT("item")).size() == 1);
+	TEST_TRUE(document->elementsByName(TXT("item"))[0] == second.get());
+}
+TEST_CASE_END
+
+TEST_CASE("the name index is updated when an element is renamed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("item")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("item")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableNameIndex();
+
+	root->appendChild(first);
+	root->appendChild(second);
+
+	TEST_TRUE(document->elementsByName(TXT("item")).size() == 2);
+
+	first->setName(TXT("renamed"));
+
+	TEST_TRUE(document->elementsByName(TXT("item")).size() == 1);
+	TEST_TRUE(document->elementsByName(TXT("item"))[0] == second.get());
+	TEST_TRUE(document->elementsByName(TXT("renamed")).size() == 1);
+	TEST_TRUE(document->elementsByName(TXT("renamed"))[0] == first.get());
+}
+TEST_CASE_END
+
+TEST_CASE("all elements with an attribute value can be found in document order")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("first")));
+	XML::ElementNodePtr second(new XML::ElementNode(TXT("second")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableAttributeIndex(TXT("type"));
+
+	first->setAttribute(TXT("type"), TXT("x"));
+	second->setAttribute(TXT("type"), TXT("x"));
+	root->appendChild(first);
+	root->appendChild(second);
+
+	TEST_TRUE(document->hasAttributeIndex(TXT("type")));
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 2);
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[0] == first.get());
+
+	first->setAttribute(TXT("type"), TXT("y"));
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 1);
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("y"))[0] == first.get());
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("z")).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("the attribute index keeps document order as elements are inserted, removed and changed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::ElementNodePtr first(new XML::ElementNode(TXT("first")));
+	XML::ElementNodePtr nested(new XML::ElementNode(TXT("nested")));
+	XML::ElementNodePtr last(new XML::ElementNode(TXT("last")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	document->enableAttributeIndex(TXT("type"));
+
+	root->appendChild(first);
+	root->appendChild(last);
+	last->setAttribute(TXT("type"), TXT("x"));
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 1);
+
+	nested->setAttribute(TXT("type"), TXT("x"));
+	first->appendChild(nested);
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 2);
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[0] == nested.get());
+
+	first->setAttribute(TXT("type"), TXT("x"));
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 3);
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[0] == first.get());
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[1] == nested.get());
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[2] == last.get());
+
+	root->removeChild(first);
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).size() == 1);
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x"))[0] == last.get());
+
+	last->getAttributes().clear();
+
+	TEST_TRUE(document->elementsByAttribute(TXT("type"), TXT("x")).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("the attribute used to identify elements can be changed")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+
+	root->setAttribute(TXT("id"), TXT("1"));
+	root->setAttribute(TXT("key"), TXT("2"));
+	document->enableIdIndex(TXT("key"));
+
+	TEST_TRUE(document->idAttribute() == TXT("key"));
+	TEST_TRUE(document->getElementById(TXT("1")).empty());
+	TEST_TRUE(document->getElementById(TXT("2")) == root);
+}
+TEST_CASE_END
+
+TEST_CASE("the generation changes whenever a node in the document is modified")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+	XML::TextNodePtr text(new XML::TextNode(TXT("text")));
+
+	size_t generation = document->generation();
+
+	root->appendChild(text);
+	TEST_TRUE(document->generation() != generation);
+	generation = document->generation();
+
+	text->setText(TXT("changed"));
+	TEST_TRUE(document->generation() != generation);
+	generation = document->generation();
+
+	root->getAttributes().set(TXT("name"), TXT("value"));
+	TEST_TRUE(document->generation() != generation);
+	generation = document->generation();
+
+	root->setName(TXT("renamed"));
+	TEST_TRUE(document->generation() != generation);
+	generation = document->generation();
+
+	root->removeChild(text);
+	TEST_TRUE(document->generation() != generation);
+	generation = document->generation();
+
+	text->setText(TXT("detached"));
+	TEST_TRUE(document->generation() == generation);
+}
+TEST_CASE_END
+
+TEST_CASE("cached query results are discarded when the document is modified")
+{
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+	XML::DocumentPtr document(new XML::Document(root));
+	XML::Nodes results;
+
+	TEST_FALSE(document->hasQueryCache());
+
+	document->enableQueryCache();
+	results.push_back(root);
+	document->cacheQueryResults(TXT("/root"), document.get(), results);
+	results.clear();
+
+	TEST_TRUE(document->hasQueryCache());
+	TEST_TRUE(document->findQueryResults(TXT("/root"), document.get(), results));
+	TEST_TRUE(results.size() == 1);
+	TEST_TRUE(results[0] == root);
+	TEST_FALSE(document->findQueryResults(TXT("/root"), root.get(), results));
+
+	root->setAttribute(TXT("name"), TXT("value"));
+
+	TEST_FALSE(document->findQueryResults(TXT("/root"), document.get(), results));
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
@@ -30,6 +30,28 @@ TEST_CASE("type returns the type of the node as an enumeration value")
 }
 TEST_CASE_END
 
+TEST_CASE("a node can be queried for and downcast to its concrete type")
+{
+	XML::NodePtr node = XML::makeElement(TXT("name"));
+
+	TEST_TRUE(node->is<XML::ElementNode>());
+	TEST_FALSE(node->is<XML::TextNode>());
+	TEST_TRUE(node->as<XML::ElementNode>()->name() == TXT("name"));
+
+	const XML::NodePtr constNode = node;
+
+	TEST_TRUE(constNode->as<XML::ElementNode>()->name() == TXT("name"));
+}
+TEST_CASE_END
+
+TEST_CASE("downcasting a node to the wrong concrete type throws an exception")
+{
+	XML::NodePtr node = XML::makeElement(TXT("name"));
+
+	TEST_THROWS(node->as<XML::TextNode>());
+}
+TEST_CASE_END
+
 TEST_CASE("default construction results in an empty name")
 {
 	XML::ElementNodePtr node(new XML::ElementNode);
@@ -89,7 +111,8 @@ TEST_CASE("an element can be constructed with a set of attributes")
 
 	TEST_TRUE(node->name() == TXT("element"));
 	TEST_TRUE(node->getAttributes().count() == 1);
-	TEST_TRUE(node->getAttributes().get(TXT("name")) == attribute);
+	TEST_TRUE(node->getAttributeValue(TXT("name")) == TXT("value"));
+	TEST_TRUE(node->getAttributes().get(TXT("name")) != attribute);
 }
 TEST_CASE_END
 
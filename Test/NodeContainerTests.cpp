@@ -125,5 +125,118 @@ TEST_CASE("iterating the children of a const node requires a const iterator")
 }
 TEST_CASE_END
 
+TEST_CASE("a child can be inserted before an existing child")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr first = XML::makeElement(TXT("first"));
+	XML::ElementNodePtr second = XML::makeElement(TXT("second"));
+	XML::ElementNodePtr third = XML::makeElement(TXT("third"));
+
+	container->appendChild(third);
+	container->insertChild(first, third);
+	container->insertChild(second, third);
+
+	TEST_TRUE(container->getChildCount() == 3);
+	TEST_TRUE(container->getChild(0) == first);
+	TEST_TRUE(container->getChild(1) == second);
+	TEST_TRUE(container->getChild(2) == third);
+	TEST_TRUE(second->parent() == container);
+}
+TEST_CASE_END
+
+TEST_CASE("inserting a child before an empty node appends it")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr first = XML::makeElement(TXT("first"));
+	XML::ElementNodePtr second = XML::makeElement(TXT("second"));
+
+	container->appendChild(first);
+	container->insertChild(second, XML::NodePtr());
+
+	TEST_TRUE(container->lastChild() == second);
+}
+TEST_CASE_END
+
+TEST_CASE("inserting a child before a node that isn't a child throws an exception")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr child = XML::makeElement(TXT("child"));
+	XML::NodePtr        orphan = XML::makeElement(TXT("orphan"));
+
+	TEST_THROWS(container->insertChild(child, orphan));
+}
+TEST_CASE_END
+
+TEST_CASE("a removed child is detached from the container and its siblings")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr first = XML::makeElement(TXT("first"));
+	XML::ElementNodePtr second = XML::makeElement(TXT("second"));
+	XML::ElementNodePtr third = XML::makeElement(TXT("third"));
+
+	container->appendChild(first);
+	container->appendChild(second);
+	container->appendChild(third);
+
+	TEST_TRUE(container->getChild(1) == second);
+
+	container->removeChild(second);
+
+	TEST_TRUE(container->getChildCount() == 2);
+	TEST_TRUE(container->getChild(1) == third);
+	TEST_TRUE(first->nextSibling() == third);
+	TEST_TRUE(third->previousSibling() == first);
+	TEST_FALSE(second->hasParent());
+	TEST_TRUE(second->nextSibling().empty());
+	TEST_TRUE(second->previousSibling().empty());
+}
+TEST_CASE_END
+
+TEST_CASE("a child can be removed via the reference held by an iterator")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr first = XML::makeElement(TXT("first"));
+	XML::ElementNodePtr second = XML::makeElement(TXT("second"));
+
+	container->appendChild(first);
+	container->appendChild(second);
+
+	container->removeChild(*container->beginChild());
+	container->removeChild(*container->beginChild());
+
+	TEST_FALSE(container->hasChildren());
+	TEST_TRUE(container->firstChild().empty());
+	TEST_TRUE(container->lastChild().empty());
+	TEST_TRUE(container->beginChild() == container->endChild());
+}
+TEST_CASE_END
+
+TEST_CASE("removing a node that isn't a child throws an exception")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr orphan = XML::makeElement(TXT("orphan"));
+
+	TEST_THROWS(container->removeChild(orphan));
+}
+TEST_CASE_END
+
+TEST_CASE("the child nodes are linked to their siblings")
+{
+	XML::ElementNodePtr container = XML::makeElement();
+	XML::ElementNodePtr first = XML::makeElement(TXT("first"));
+	XML::ElementNodePtr second = XML::makeElement(TXT("second"));
+
+	container->appendChild(first);
+	container->appendChild(second);
+
+	TEST_TRUE(container->firstChild() == first);
+	TEST_TRUE(container->lastChild() == second);
+	TEST_TRUE(first->previousSibling().empty());
+	TEST_TRUE(first->nextSibling() == second);
+	TEST_TRUE(second->previousSibling() == first);
+	TEST_TRUE(second->nextSibling().empty());
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
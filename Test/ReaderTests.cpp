@@ -11,6 +11,24 @@
 #include <XML/CommentNode.hpp>
 #include <XML/ProcessingNode.hpp>
 #include <XML/DocTypeNode.hpp>
+#include <XML/XPathExpression.hpp>
+#include <XML/Writer.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The handler used to collect the matches when streaming.
+
+class MatchCollector : public XML::Reader::MatchHandler
+{
+public:
+	//! Handle an element that matched.
+	virtual void onMatch(const XML::ElementNodePtr& element)
+	{
+		m_matches.push_back(element);
+	}
+
+	//! The matches, in the order they were handled.
+	std::vector<XML::ElementNodePtr> m_matches;
+};
 
 TEST_SET(Reader)
 {
@@ -189,7 +207,7 @@ TEST_CASE("child tag order maintained")
 	TEST_TRUE(document->getChildCount() == 9);
 	TEST_TRUE(document->getRootElement()->name() == TXT("R"));
 
-	XML::Nodes::iterator it = document->beginChild();
+	XML::NodeContainer::iterator it = document->beginChild();
 
 	TEST_TRUE((*it)->type() == XML::TEXT_NODE);
 	TEST_TRUE(Core::dynamic_ptr_cast<XML::TextNode>(*it)->text() == TXT("  "));
@@ -199,17 +217,17 @@ TEST_CASE("child tag order maintained")
 	TEST_TRUE((*it)->type() == XML::PROCESSING_NODE);
 	TEST_TRUE(Core::dynamic_ptr_cast<XML::ProcessingNode>(*it)->target() == TXT("P"));
 
-	it += 2;
+	std::advance(it, 2);
 
 	TEST_TRUE((*it)->type() == XML::DOCTYPE_NODE);
 	TEST_TRUE(Core::dynamic_ptr_cast<XML::DocTypeNode>(*it)->declaration() == TXT(" R"));
 
-	it += 2;
+	std::advance(it, 2);
 
 	TEST_TRUE((*it)->type() == XML::COMMENT_NODE);
 	TEST_TRUE(Core::dynamic_ptr_cast<XML::CommentNode>(*it)->comment() == TXT(""));
 
-	it += 2;
+	std::advance(it, 2);
 
 	TEST_TRUE((*it)->type() == XML::ELEMENT_NODE);
 
@@ -290,5 +308,232 @@ TEST_CASE("the document can be parsed using a single method call")
 }
 TEST_CASE_END
 
+TEST_CASE("the elements can be indexed by ID during parsing")
+{
+	const tstring xml = TXT("<root id=\"1\"><child id=\"2\"/></root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, XML::Reader::BUILD_ID_INDEX);
+
+	TEST_TRUE(document->hasIdIndex());
+	TEST_TRUE(document->getElementById(TXT("2"))->name() == TXT("child"));
+}
+TEST_CASE_END
+
+TEST_CASE("the elements can be indexed by name during parsing")
+{
+	const tstring xml = TXT("<root><child/><other><child/></other></root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, XML::Reader::BUILD_NAME_INDEX);
+
+	TEST_TRUE(document->hasNameIndex());
+	TEST_TRUE(document->elementsByName(TXT("child")).size() == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("the indexes built during parsing list nested elements in document order")
+{
+	const tstring xml = TXT("<root><a id='1'><b id='2'><c/></b></a><b id='3'/>text<c/></root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, XML::Reader::BUILD_ID_INDEX | XML::Reader::BUILD_NAME_INDEX);
+
+	const XML::Document::Elements& elements = document->elementsByName(TXT("c"));
+
+	TEST_TRUE(elements.size() == 2);
+	TEST_TRUE(elements[0]->parent() == document->getElementById(TXT("2")));
+	TEST_TRUE(elements[1]->parent() == document->getRootElement());
+	TEST_TRUE(document->getElementById(TXT("2"))->parent() == document->getElementById(TXT("1")));
+	TEST_TRUE(document->getElementById(TXT("3"))->name() == TXT("b"));
+}
+TEST_CASE_END
+
+TEST_CASE("the predefined entity and character references in values are decoded")
+{
+	const tstring xml = TXT("<root key='&quot;&apos;&#x41;'>&lt;&amp;&gt;&#65;&unknown;&#0;</root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	TEST_TRUE(document->getRootElement()->getAttributeValue(TXT("key")) == TXT("\"'A"));
+	TEST_TRUE(document->getRootElement()->getTextValue() == TXT("<&>A&unknown;&#0;"));
+}
+TEST_CASE_END
+
+TEST_CASE("character references that can't be represented by a single character are left as is")
+{
+	const tstring xml = TXT("<root>&#127;&#233;&#x10000;</root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	const tstring expected = (sizeof(tchar) == 1) ? TXT("\x7F&#233;&#x10000;") : TXT("\x7F\xE9&#x10000;");
+
+	TEST_TRUE(document->getRootElement()->getTextValue() == expected);
+}
+TEST_CASE_END
+
+TEST_CASE("a reference longer than any that can be decoded is left as is")
+{
+	const tstring xml = TXT("<root>&#00000000000000065;&#0000000000065; & ;</root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	TEST_TRUE(document->getRootElement()->getTextValue() == TXT("&#00000000000000065;A & ;"));
+}
+TEST_CASE_END
+
+TEST_CASE("streaming only builds the subtrees that match the expression")
+{
+	const tstring xml = TXT("<A><B ID='1'><C/></B><X><B ID='2'>text</B></X><B ID='3' T='x'/></A>");
+
+	MatchCollector collector;
+
+	XML::Reader::readMatches(xml, XML::XPathExpression(TXT("//B")), collector);
+
+	TEST_TRUE(collector.m_matches.size() == 3);
+	TEST_TRUE(collector.m_matches[0]->getAttributeValue(TXT("ID")) == TXT("1"));
+	TEST_TRUE(collector.m_matches[0]->getChildCount() == 1);
+	TEST_TRUE(collector.m_matches[1]->getAttributeValue(TXT("ID")) == TXT("2"));
+	TEST_TRUE(collector.m_matches[1]->getChildCount() == 1);
+	TEST_TRUE(collector.m_matches[2]->getAttributeValue(TXT("ID")) == TXT("3"));
+	TEST_FALSE(collector.m_matches[0]->hasParent());
+}
+TEST_CASE_END
+
+TEST_CASE("streaming supports attribute predicates and positions")
+{
+	const tstring xml = TXT("<A><B ID='1'/><X><B ID='2'/><B ID='3' T='x'/></X></A>");
+
+	MatchCollector byAttribute;
+	MatchCollector byPosition;
+
+	XML::Reader::readMatches(xml, XML::XPathExpression(TXT("//B[@T='x']")), byAttribute);
+	XML::Reader::readMatches(xml, XML::XPathExpression(TXT("/A/X/B[2]")), byPosition);
+
+	TEST_TRUE(byAttribute.m_matches.size() == 1);
+	TEST_TRUE(byAttribute.m_matches[0]->getAttributeValue(TXT("ID")) == TXT("3"));
+	TEST_TRUE(byPosition.m_matches.size() == 1);
+	TEST_TRUE(byPosition.m_matches[0]->getAttributeValue(TXT("ID")) == TXT("3"));
+}
+TEST_CASE_END
+
+TEST_CASE("a match nested inside another match is part of the outer match")
+{
+	const tstring xml = TXT("<A><B ID='1'><B ID='2'/></B></A>");
+
+	MatchCollector collector;
+
+	XML::Reader::readMatches(xml, XML::XPathExpression(TXT("//B")), collector);
+
+	TEST_TRUE(collector.m_matches.size() == 1);
+	TEST_TRUE(collector.m_matches[0]->getChildCount() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("streaming still validates the entire document")
+{
+	MatchCollector collector;
+
+	TEST_THROWS(XML::Reader::readMatches(TXT("<A><B></C></A>"), XML::XPathExpression(TXT("//X")), collector));
+	TEST_THROWS(XML::Reader::readMatches(TXT("<A>"), XML::XPathExpression(TXT("//X")), collector));
+	TEST_THROWS(XML::Reader::readMatches(TXT(""), XML::XPathExpression(TXT("//X")), collector));
+}
+TEST_CASE_END
+
+TEST_CASE("streaming throws when the expression needs the content of a match")
+{
+	MatchCollector collector;
+
+	TEST_THROWS(XML::Reader::readMatches(TXT("<A/>"), XML::XPathExpression(TXT("//A[B='x']")), collector));
+}
+TEST_CASE_END
+
+TEST_CASE("nodes only record their span of the source when the source is kept")
+{
+	const tstring xml = TXT("<A x='1'><B/>text<!--c--></A>");
+
+	XML::DocumentPtr plain = XML::Reader::readDocument(xml);
+
+	TEST_FALSE(plain->hasSourceText());
+	TEST_FALSE(plain->getRootElement()->hasSource());
+
+	XML::DocumentPtr    document = XML::Reader::readDocument(xml, XML::Reader::KEEP_SOURCE);
+	XML::ElementNodePtr root = document->getRootElement();
+
+	TEST_TRUE(document->sourceText() == xml);
+	TEST_TRUE(root->hasSource());
+	TEST_TRUE(root->sourceBegin() == 0);
+	TEST_TRUE(root->sourceEnd() == xml.length());
+	TEST_TRUE(root->startTagSourceEnd() == 9);
+
+	for (size_t i = 0; i != root->getChildCount(); ++i)
+	{
+		const XML::NodePtr child = root->getChild(i);
+
+		TEST_TRUE(child->hasSource());
+	}
+
+	TEST_TRUE(xml.substr(root->getChild(1)->sourceBegin(), 4) == TXT("text"));
+	TEST_TRUE(root->getChild(2)->sourceEnd() == xml.length() - 4);
+}
+TEST_CASE_END
+
+TEST_CASE("modifying a node drops its source span and those of its ancestors")
+{
+	XML::DocumentPtr    document = XML::Reader::readDocument(TXT("<A><B><C/></B><D/></A>"), XML::Reader::KEEP_SOURCE);
+	XML::ElementNodePtr root = document->getRootElement();
+	XML::ElementNodePtr b = root->findFirstElement(TXT("B"));
+	XML::ElementNodePtr c = b->findFirstElement(TXT("C"));
+	XML::ElementNodePtr d = root->findFirstElement(TXT("D"));
+
+	c->setAttribute(TXT("x"), TXT("1"));
+
+	TEST_FALSE(c->hasSource());
+	TEST_FALSE(c->hasStartTagSource());
+	TEST_FALSE(b->hasSource());
+	TEST_TRUE(b->hasStartTagSource());
+	TEST_FALSE(root->hasSource());
+	TEST_TRUE(d->hasSource());
+
+	root->removeChild(d);
+
+	TEST_FALSE(d->hasSource());
+}
+TEST_CASE_END
+
+TEST_CASE("no nodes are discarded when the source is kept")
+{
+	const tstring xml = TXT("<!DOCTYPE A><A> <?p?><!--c--><B>t</B></A>");
+	const uint    discard = XML::Reader::DISCARD_WHITESPACE | XML::Reader::DISCARD_COMMENTS
+						  | XML::Reader::DISCARD_PROC_INSTNS | XML::Reader::DISCARD_DOC_TYPES;
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, discard | XML::Reader::KEEP_SOURCE);
+
+	TEST_TRUE(document->getChildCount() == 2);
+	TEST_TRUE(document->getRootElement()->getChildCount() == 4);
+
+	document->getRootElement()->findFirstElement(TXT("B"))->setName(TXT("C"));
+
+	TEST_TRUE(XML::Writer::writeDocument(document, XML::Writer::PRESERVE_SOURCE) == TXT("<!DOCTYPE A><A> <?p?><!--c--><C>t</C></A>"));
+}
+TEST_CASE_END
+
+TEST_CASE("every combination of the discard flags only discards those node types")
+{
+	const tstring xml = TXT("<!DOCTYPE A><A> <?p?><!--c--><B>t</B></A>");
+
+	for (uint flags = 0; flags != 16; ++flags)
+	{
+		XML::DocumentPtr    document = XML::Reader::readDocument(xml, flags);
+		XML::ElementNodePtr root = document->getRootElement();
+
+		const size_t docTypes = ((flags & XML::Reader::DISCARD_DOC_TYPES) != 0) ? 0 : 1;
+		const size_t children = 1 + (((flags & XML::Reader::DISCARD_WHITESPACE) != 0) ? 0 : 1)
+								  + (((flags & XML::Reader::DISCARD_PROC_INSTNS) != 0) ? 0 : 1)
+								  + (((flags & XML::Reader::DISCARD_COMMENTS) != 0) ? 0 : 1);
+
+		TEST_TRUE(document->getChildCount() == (1 + docTypes));
+		TEST_TRUE(root->getChildCount() == children);
+	}
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StreamWriterTests.cpp
+//! \brief  The unit tests for the StreamWriter class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/StreamWriter.hpp>
+#include <XML/StreamSink.hpp>
+#include <XML/Reader.hpp>
+#include <sstream>
+
+TEST_SET(StreamWriter)
+{
+	typedef std::basic_ostringstream<tchar> tostringstream;
+
+TEST_CASE("Nothing is written when the document has no content")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink);
+
+	writer.endDocument();
+
+	TEST_TRUE(stream.str() == TXT(""));
+}
+TEST_CASE_END
+
+TEST_CASE("Elements, attributes and text are written as they would be for the equivalent document")
+{
+	const tchar* xml = TXT("<root a=\"1\"><empty/><value b=\"x&amp;y\">a&lt;b</value><!--note--><parent><child/></parent></root>");
+	const uint   flagSets[] = { XML::Writer::DEFAULT, XML::Writer::NO_FORMATTING };
+
+	for (size_t i = 0; i != ARRAY_SIZE(flagSets); ++i)
+	{
+		tostringstream     stream;
+		XML::StreamSink    sink(stream);
+		XML::StreamWriter  writer(sink, flagSets[i]);
+
+		writer.startElement(TXT("root"));
+		writer.attribute(TXT("a"), TXT("1"));
+		writer.startElement(TXT("empty"));
+		writer.endElement();
+		writer.startElement(TXT("value"));
+		writer.attribute(TXT("b"), TXT("x&y"));
+		writer.text(TXT("a<b"));
+		writer.endElement();
+		writer.comment(TXT("note"));
+		writer.startElement(TXT("parent"));
+		writer.startElement(TXT("child"));
+		writer.endElement();
+		writer.endElement();
+		writer.endElement();
+		writer.endDocument();
+
+		const tstring expected = XML::Writer::writeDocument(XML::Reader::readDocument(xml), flagSets[i]);
+
+		TEST_TRUE(stream.str() == expected);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("A CDATA section is written inline and split around its terminator")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink, XML::Writer::NO_FORMATTING);
+
+	writer.startElement(TXT("root"));
+	writer.cdata(TXT("a]]>b"));
+	writer.endElement();
+	writer.endDocument();
+
+	TEST_TRUE(stream.str() == TXT("<root><![CDATA[a]]]]><![CDATA[>b]]></root>"));
+}
+TEST_CASE_END
+
+TEST_CASE("The depth is the number of open elements")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink);
+
+	TEST_TRUE(writer.depth() == 0);
+
+	writer.startElement(TXT("root"));
+	writer.startElement(TXT("child"));
+
+	TEST_TRUE(writer.depth() == 2);
+
+	writer.endElement();
+
+	TEST_TRUE(writer.depth() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("Calls that would produce malformed XML throw")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink);
+
+	TEST_THROWS(writer.endElement());
+	TEST_THROWS(writer.attribute(TXT("a"), TXT("1")));
+	TEST_THROWS(writer.text(TXT("text")));
+
+	writer.startElement(TXT("root"));
+	writer.text(TXT("text"));
+
+	TEST_THROWS(writer.attribute(TXT("a"), TXT("1")));
+	TEST_THROWS(writer.endDocument());
+
+	writer.endElement();
+
+	TEST_THROWS(writer.startElement(TXT("second")));
+	TEST_THROWS(writer.cdata(TXT("text")));
+}
+TEST_CASE_END
+
+TEST_CASE("An attribute can't be written twice for the same element")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink, XML::Writer::NO_FORMATTING);
+
+	writer.startElement(TXT("root"));
+	writer.attribute(TXT("a"), TXT("1"));
+
+	TEST_THROWS(writer.attribute(TXT("a"), TXT("2")));
+
+	writer.startElement(TXT("child"));
+	writer.attribute(TXT("a"), TXT("3"));
+	writer.endElement();
+	writer.endElement();
+	writer.endDocument();
+
+	TEST_TRUE(stream.str() == TXT("<root a=\"1\"><child a=\"3\"/></root>"));
+}
+TEST_CASE_END
+
+TEST_CASE("A comment can't contain a double hyphen or end with a hyphen")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink, XML::Writer::NO_FORMATTING);
+
+	TEST_THROWS(writer.comment(TXT("a--b")));
+	TEST_THROWS(writer.comment(TXT("a-")));
+	TEST_THROWS(writer.comment(TXT("-")));
+
+	writer.comment(TXT("-a-b"));
+	writer.startElement(TXT("root"));
+	writer.endElement();
+	writer.endDocument();
+
+	TEST_TRUE(stream.str() == TXT("<!---a-b--><root/>"));
+}
+TEST_CASE_END
+
+TEST_CASE("The output is written to the sink in chunks as the buffer fills")
+{
+	tostringstream     stream;
+	XML::StreamSink    sink(stream);
+	XML::StreamWriter  writer(sink, XML::Writer::NO_FORMATTING);
+	const tstring      text(XML::Writer::BUFFER_SIZE, TXT('x'));
+
+	writer.startElement(TXT("root"));
+	writer.text(text);
+
+	TEST_TRUE(stream.str().length() >= XML::Writer::BUFFER_SIZE);
+
+	writer.endElement();
+	writer.endDocument();
+
+	TEST_TRUE(stream.str() == TXT("<root>") + text + TXT("</root>"));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StringMapTests.cpp
+//! \brief  The unit tests for the StringMap class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/StringMap.hpp>
+#include <Core/StringUtils.hpp>
+
+TEST_SET(StringMap)
+{
+
+TEST_CASE("default construction creates an empty map")
+{
+	XML::StringMap<int> map;
+
+	TEST_TRUE(map.isEmpty());
+	TEST_TRUE(map.count() == 0);
+	TEST_TRUE(map.find(TXT("key")) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("indexing by an unknown key adds a default value")
+{
+	XML::StringMap<int> map;
+
+	TEST_TRUE(map[TXT("key")] == 0);
+	TEST_TRUE(map.count() == 1);
+	TEST_TRUE(map.find(TXT("key")) != nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("a value can be found by its key")
+{
+	XML::StringMap<int> map;
+
+	map[TXT("one")] = 1;
+	map[TXT("two")] = 2;
+
+	TEST_TRUE(*map.find(TXT("one")) == 1);
+	TEST_TRUE(*map.find(TXT("two")) == 2);
+	TEST_TRUE(map.find(TXT("three")) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("an entry can be erased by its key")
+{
+	XML::StringMap<int> map;
+
+	map[TXT("one")] = 1;
+	map[TXT("two")] = 2;
+
+	TEST_TRUE(map.erase(TXT("one")));
+	TEST_FALSE(map.erase(TXT("one")));
+	TEST_TRUE(map.find(TXT("one")) == nullptr);
+	TEST_TRUE(*map.find(TXT("two")) == 2);
+	TEST_TRUE(map.count() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("the entries are kept when the map grows")
+{
+	const int count = 1000;
+
+	XML::StringMap<int> map;
+
+	for (int i = 0; i != count; ++i)
+		map[Core::fmt(TXT("%d"), i)] = i;
+
+	TEST_TRUE(map.count() == static_cast<size_t>(count));
+
+	bool found = true;
+
+	for (int i = 0; i != count; ++i)
+	{
+		const int* value = map.find(Core::fmt(TXT("%d"), i));
+
+		if ( (value == nullptr) || (*value != i) )
+			found = false;
+	}
+
+	TEST_TRUE(found);
+}
+TEST_CASE_END
+
+TEST_CASE("clearing the map removes all the entries")
+{
+	XML::StringMap<int> map;
+
+	map[TXT("one")] = 1;
+	map.clear();
+
+	TEST_TRUE(map.isEmpty());
+	TEST_TRUE(map.find(TXT("one")) == nullptr);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
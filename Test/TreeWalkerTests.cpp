@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TreeWalkerTests.cpp
+//! \brief  The unit tests for the TreeWalker class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/TreeWalker.hpp>
+#include <XML/Reader.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CommentNode.hpp>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A visitor that records the sequence of callbacks.
+
+class RecordingVisitor : public XML::NodeVisitor
+{
+public:
+	RecordingVisitor(const tstring& skip = TXT(""), const tstring& stop = TXT(""))
+		: m_skip(skip), m_stop(stop), m_trace()
+	{
+	}
+
+	virtual Action enterDocument(const XML::Document& /*document*/)
+	{
+		m_trace += TXT("[");
+		return CONTINUE;
+	}
+
+	virtual Action leaveDocument(const XML::Document& /*document*/)
+	{
+		m_trace += TXT("]");
+		return CONTINUE;
+	}
+
+	virtual Action enterElement(const XML::ElementNode& element)
+	{
+		m_trace += TXT("<") + element.name();
+
+		if (element.name() == m_stop)
+			return STOP;
+
+		return (element.name() == m_skip) ? SKIP_CHILDREN : CONTINUE;
+	}
+
+	virtual Action leaveElement(const XML::ElementNode& element)
+	{
+		m_trace += TXT("/") + element.name() + TXT(">");
+		return CONTINUE;
+	}
+
+	virtual Action visitText(const XML::TextNode& text)
+	{
+		m_trace += text.text();
+		return CONTINUE;
+	}
+
+	virtual Action visitComment(const XML::CommentNode& comment)
+	{
+		m_trace += TXT("!") + comment.comment();
+		return CONTINUE;
+	}
+
+	tstring	m_skip;
+	tstring	m_stop;
+	tstring	m_trace;
+};
+
+}
+
+TEST_SET(TreeWalker)
+{
+	const tstring xml = TXT("<A><B>b</B><!--c--><C><D/></C>e</A>");
+
+TEST_CASE("containers are entered before and left after their children")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	RecordingVisitor visitor;
+
+	const bool completed = XML::TreeWalker::walkTree(*document, visitor);
+
+	TEST_TRUE(completed);
+	TEST_TRUE(visitor.m_trace == TXT("[<A<Bb/B>!c<C<D/D>/C>e/A>]"));
+}
+TEST_CASE_END
+
+TEST_CASE("a walk is bounded by the starting node")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	XML::ElementNodePtr root = document->getRootElement();
+	RecordingVisitor visitor;
+
+	XML::TreeWalker::walkTree(*root->getChild(0), visitor);
+
+	TEST_TRUE(visitor.m_trace == TXT("<Bb/B>"));
+}
+TEST_CASE_END
+
+TEST_CASE("the children of an element can be skipped")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	RecordingVisitor visitor(TXT("C"));
+
+	XML::TreeWalker::walkTree(*document, visitor);
+
+	TEST_TRUE(visitor.m_trace == TXT("[<A<Bb/B>!c<C/C>e/A>]"));
+}
+TEST_CASE_END
+
+TEST_CASE("the walk can be stopped early")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	RecordingVisitor visitor(TXT(""), TXT("C"));
+
+	const bool completed = XML::TreeWalker::walkTree(*document, visitor);
+
+	TEST_FALSE(completed);
+	TEST_TRUE(visitor.m_trace == TXT("[<A<Bb/B>!c<C"));
+}
+TEST_CASE_END
+
+TEST_CASE("a walker can be reused for another walk")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	XML::TreeWalker walker;
+	RecordingVisitor first(TXT(""), TXT("D"));
+	RecordingVisitor second;
+
+	walker.walk(*document, first);
+	walker.walk(*document, second);
+
+	TEST_TRUE(second.m_trace == TXT("[<A<Bb/B>!c<C<D/D>/C>e/A>]"));
+}
+TEST_CASE_END
+
+TEST_CASE("a deeply nested document can be walked without recursion")
+{
+	const size_t depth = 1000;
+
+	XML::DocumentPtr    document = XML::makeDocument();
+	XML::ElementNodePtr parent = XML::makeElement(TXT("E"));
+
+	document->appendChild(parent);
+
+	for (size_t i = 1; i != depth; ++i)
+	{
+		XML::ElementNodePtr child = XML::makeElement(TXT("E"));
+
+		parent->appendChild(child);
+		parent = child;
+	}
+
+	RecordingVisitor visitor;
+
+	XML::TreeWalker::walkTree(*document, visitor);
+
+	TEST_TRUE(visitor.m_trace.length() == (2 + (depth * 5)));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -7,6 +7,41 @@
 #include <Core/UnitTest.hpp>
 #include <XML/Writer.hpp>
 #include <XML/TextNode.hpp>
+#include <XML/FileSink.hpp>
+#include <XML/StreamSink.hpp>
+#include <XML/DescriptorSink.hpp>
+#include <XML/Reader.hpp>
+#include <XML/CDataNode.hpp>
+#include <XML/DocTypeNode.hpp>
+#include <sstream>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The sink used to collect the chunks written.
+
+class ChunkCollector : public XML::OutputSink
+{
+public:
+	//! Write a chunk of text.
+	virtual void write(const tchar* text, size_t length)
+	{
+		m_chunks.push_back(tstring(text, text+length));
+	}
+
+	//! Write a sequence of chunks of text.
+	virtual void writeChunks(const Chunk* chunks, size_t count)
+	{
+		for (size_t i = 0; i != count; ++i)
+			m_gathered.push_back(chunks[i].m_text);
+
+		XML::OutputSink::writeChunks(chunks, count);
+	}
+
+	//! The chunks, in the order they were written.
+	std::vector<tstring> m_chunks;
+	//! The text of the chunks passed in gather writes.
+	std::vector<const tchar*> m_gathered;
+};
 
 TEST_SET(Writer)
 {
@@ -133,6 +168,45 @@ TEST_CASE("The indenting style can be overridden")
 }
 TEST_CASE_END
 
+TEST_CASE("Deep indentation is written in full for tab, space and other indenting styles")
+{
+	const tchar* styles[] = { TXT("\t"), TXT("  "), TXT("   "), TXT("-."), TXT(" \t") };
+	const size_t depth = 100;
+
+	XML::DocumentPtr    document = XML::makeDocument();
+	XML::ElementNodePtr parent = XML::makeElement(TXT("E"));
+
+	document->appendChild(parent);
+
+	for (size_t i = 1; i != depth; ++i)
+	{
+		XML::ElementNodePtr child = XML::makeElement(TXT("E"));
+
+		parent->appendChild(child);
+		parent = child;
+	}
+
+	for (size_t i = 0; i != ARRAY_SIZE(styles); ++i)
+	{
+		const tstring style = styles[i];
+		tstring       indentation;
+		tstring       startTags;
+		tstring       endTags;
+
+		for (size_t level = 0; level != depth-1; ++level, indentation += style)
+		{
+			startTags += indentation + TXT("<E>\n");
+			endTags = indentation + TXT("</E>\n") + endTags;
+		}
+
+		const tstring expected = startTags + indentation + TXT("<E/>\n") + endTags;
+
+		TEST_TRUE(XML::Writer::writeDocument(document, XML::Writer::DEFAULT, styles[i]) == expected);
+		TEST_TRUE(XML::Writer::measure(document, XML::Writer::DEFAULT, styles[i]) == expected.length());
+	}
+}
+TEST_CASE_END
+
 TEST_CASE("A child text node is written between the element tags when no formatting is specified")
 {
 	XML::DocumentPtr document = XML::makeDocument
@@ -171,5 +245,459 @@ TEST_CASE("A single child text node and the element tags are written on the same
 }
 TEST_CASE_END
 
+TEST_CASE("A single child CDATA section and the element tags are written on the same line")
+{
+	XML::DocumentPtr document = XML::makeDocument
+	(
+		XML::makeElement
+		(
+			TXT("root"), XML::makeElement
+			(
+				TXT("element"), XML::CDataNodePtr(new XML::CDataNode(TXT("<value>")))
+			)
+		)
+	);
+
+	const tstring output = XML::Writer::writeDocument(document, XML::Writer::DEFAULT, TXT("  "));
+
+	TEST_TRUE(output == TXT("<root>\n  <element><![CDATA[<value>]]></element>\n</root>\n"));
+}
+TEST_CASE_END
+
+TEST_CASE("The markup characters in text are written as entity references")
+{
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root"), XML::makeText(TXT("a<b & c>d \"e\" 'f'"))));
+
+	const tstring output = XML::Writer::writeDocument(document, defaultTestFlags);
+
+	TEST_TRUE(output == TXT("<root>a&lt;b &amp; c&gt;d \"e\" 'f'</root>"));
+}
+TEST_CASE_END
+
+TEST_CASE("The markup characters, quotes and white-space in attribute values are written as references")
+{
+	XML::DocumentPtr    document = XML::makeDocument(XML::makeElement(TXT("root")));
+	XML::ElementNodePtr root = document->getRootElement();
+
+	root->setAttribute(TXT("key"), TXT("<&>\"'\t\n"));
+
+	const tstring output = XML::Writer::writeDocument(document, defaultTestFlags);
+
+	TEST_TRUE(output == TXT("<root key=\"&lt;&amp;&gt;&quot;&apos;&#9;&#10;\"/>"));
+}
+TEST_CASE_END
+
+TEST_CASE("Escaped text and attribute values are read back unchanged")
+{
+	const tstring text = TXT("1 < 2 && \"x\" > 'y'");
+
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root"), XML::makeText(text)));
+
+	document->getRootElement()->setAttribute(TXT("key"), text);
+
+	XML::DocumentPtr copy = XML::Reader::readDocument(XML::Writer::writeDocument(document, defaultTestFlags));
+
+	TEST_TRUE(copy->getRootElement()->getTextValue() == text);
+	TEST_TRUE(copy->getRootElement()->getAttributeValue(TXT("key")) == text);
+}
+TEST_CASE_END
+
+TEST_CASE("Long runs of text, including non-ASCII characters, are written with every escaped character at any position")
+{
+	const tchar nonAscii[] = { static_cast<tchar>(0xE9), static_cast<tchar>(0xA0), static_cast<tchar>(0xFF), static_cast<tchar>(0x80) };
+	const tchar specials[] = { TXT('<'), TXT('>'), TXT('&'), TXT('\"'), TXT('\''), TXT('\t'), TXT('\n'), TXT('\r') };
+	const tchar* textReferences[] = { TXT("&lt;"), TXT("&gt;"), TXT("&amp;"), TXT("\""), TXT("'"), TXT("\t"), TXT("\n"), TXT("\r") };
+	const tchar* attributeReferences[] = { TXT("&lt;"), TXT("&gt;"), TXT("&amp;"), TXT("&quot;"), TXT("&apos;"), TXT("&#9;"), TXT("&#10;"), TXT("&#13;") };
+
+	tstring clean;
+
+	for (size_t i = 0; i != 1000; ++i)
+		clean += (i % 3 == 0) ? nonAscii[i % ARRAY_SIZE(nonAscii)] : static_cast<tchar>(TXT('a') + (i % 26));
+
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("r"), XML::makeText(clean)));
+
+	document->getRootElement()->setAttribute(TXT("k"), clean);
+
+	TEST_TRUE(XML::Writer::writeDocument(document, defaultTestFlags) == TXT("<r k=\"") + clean + TXT("\">") + clean + TXT("</r>"));
+
+	for (size_t i = 0; i != ARRAY_SIZE(specials); ++i)
+	{
+		for (size_t offset = 0; offset != 40; ++offset)
+		{
+			const tstring prefix = clean.substr(0, offset);
+			const tstring suffix = clean.substr(0, 40);
+			const tstring value = prefix + specials[i] + suffix;
+
+			XML::DocumentPtr valueDocument = XML::makeDocument(XML::makeElement(TXT("r"), XML::makeText(value)));
+
+			valueDocument->getRootElement()->setAttribute(TXT("k"), value);
+
+			const tstring expected = TXT("<r k=\"") + prefix + attributeReferences[i] + suffix + TXT("\">")
+			                       + prefix + textReferences[i] + suffix + TXT("</r>");
+
+			TEST_TRUE(XML::Writer::writeDocument(valueDocument, defaultTestFlags) == expected);
+		}
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("Comments, processing instructions, document types and CDATA sections are written back as read")
+{
+	const tstring xml = TXT("<?xml version=\"1.0\"?><!DOCTYPE root><!--comment-->")
+						TXT("<root><![CDATA[<data>]]><?target key=\"value\"?><!--inner--></root>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	const tstring output = XML::Writer::writeDocument(document, defaultTestFlags);
+
+	TEST_TRUE(output == xml);
+}
+TEST_CASE_END
+
+TEST_CASE("A CDATA section containing its terminator is split into two sections")
+{
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root")));
+
+	document->getRootElement()->appendChild(XML::CDataNodePtr(new XML::CDataNode(TXT("a]]>b"))));
+
+	const tstring output = XML::Writer::writeDocument(document, defaultTestFlags);
+
+	TEST_TRUE(output == TXT("<root><![CDATA[a]]]]><![CDATA[>b]]></root>"));
+}
+TEST_CASE_END
+
+TEST_CASE("A document type created without leading white-space is separated from the keyword")
+{
+	XML::DocumentPtr document(new XML::Document);
+
+	document->appendChild(XML::DocTypeNodePtr(new XML::DocTypeNode(TXT("root"))));
+	document->appendChild(XML::makeElement(TXT("root")));
+
+	const tstring output = XML::Writer::writeDocument(document);
+
+	TEST_TRUE(output == TXT("<!DOCTYPE root>\n<root/>\n"));
+}
+TEST_CASE_END
+
+TEST_CASE("A document can be streamed to a sink in bounded chunks")
+{
+	XML::DocumentPtr    document(new XML::Document);
+	XML::ElementNodePtr root(new XML::ElementNode(TXT("root")));
+
+	document->appendChild(root);
+
+	for (size_t i = 0; i != 5000; ++i)
+		root->appendChild(XML::makeElement(TXT("element"), XML::makeText(TXT("value"))));
+
+	ChunkCollector collector;
+	tstring        streamed;
+
+	XML::Writer::writeDocument(document, collector, defaultTestFlags);
+
+	TEST_TRUE(collector.m_chunks.size() > 1);
+
+	for (size_t i = 0; i != collector.m_chunks.size(); ++i)
+	{
+		TEST_TRUE(collector.m_chunks[i].size() < (XML::Writer::BUFFER_SIZE + 64));
+		streamed += collector.m_chunks[i];
+	}
+
+	TEST_TRUE(streamed == XML::Writer::writeDocument(document, defaultTestFlags));
+}
+TEST_CASE_END
+
+TEST_CASE("A document can be streamed to a standard output stream")
+{
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root")));
+
+	std::basic_ostringstream<tchar> stream;
+	XML::StreamSink                 sink(stream);
+
+	XML::Writer::writeDocument(document, sink, defaultTestFlags);
+
+	TEST_TRUE(stream.str() == TXT("<root/>"));
+}
+TEST_CASE_END
+
+TEST_CASE("A document can be streamed to a C file stream")
+{
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root")));
+	FILE*            file = tmpfile();
+
+	TEST_TRUE(file != nullptr);
+
+	XML::FileSink sink(file);
+
+	XML::Writer::writeDocument(document, sink, defaultTestFlags);
+
+	tchar        buffer[16] = { 0 };
+	const size_t length = ftell(file) / sizeof(tchar);
+
+	rewind(file);
+
+	TEST_TRUE(fread(buffer, sizeof(tchar), length, file) == length);
+	TEST_TRUE(tstring(buffer, buffer+length) == TXT("<root/>"));
+
+	fclose(file);
+}
+TEST_CASE_END
+
+TEST_CASE("Large values are passed to a sink by reference rather than copied")
+{
+	XML::TextNodePtr  text(new XML::TextNode(tstring(1000, TXT('x'))));
+	XML::CDataNodePtr cdata(new XML::CDataNode(tstring(1000, TXT('y'))));
+	XML::DocumentPtr  document = XML::makeDocument(XML::makeElement(TXT("root")));
+
+	document->getRootElement()->appendChild(XML::makeElement(TXT("text"), text));
+	document->getRootElement()->appendChild(cdata);
+
+	ChunkCollector collector;
+	tstring        streamed;
+
+	XML::Writer::writeDocument(document, collector);
+
+	for (size_t i = 0; i != collector.m_chunks.size(); ++i)
+		streamed += collector.m_chunks[i];
+
+	TEST_TRUE(streamed == XML::Writer::writeDocument(document));
+	TEST_TRUE(std::find(collector.m_gathered.begin(), collector.m_gathered.end(), text->text().data()) != collector.m_gathered.end());
+	TEST_TRUE(std::find(collector.m_gathered.begin(), collector.m_gathered.end(), cdata->text().data()) != collector.m_gathered.end());
+}
+TEST_CASE_END
+
+TEST_CASE("A document with many large values can be streamed to a file descriptor")
+{
+	XML::DocumentPtr document = XML::makeDocument(XML::makeElement(TXT("root")));
+
+	for (size_t i = 0; i != 200; ++i)
+		document->getRootElement()->appendChild(XML::makeElement(TXT("e"), XML::makeText(tstring(300, TXT('a')+(i%26)))));
+
+	FILE* file = tmpfile();
+
+	TEST_TRUE(file != nullptr);
+
+	XML::DescriptorSink sink(fileno(file));
+
+	XML::Writer::writeDocument(document, sink, defaultTestFlags);
+
+	const tstring expected = XML::Writer::writeDocument(document, defaultTestFlags);
+
+	fseek(file, 0, SEEK_END);
+
+	const size_t       length = ftell(file) / sizeof(tchar);
+	std::vector<tchar> buffer(length+1);
+
+	rewind(file);
+
+	TEST_TRUE(length == expected.length());
+	TEST_TRUE(fread(&buffer[0], sizeof(tchar), length, file) == length);
+	TEST_TRUE(tstring(&buffer[0], &buffer[0]+length) == expected);
+
+	fclose(file);
+}
+TEST_CASE_END
+
+TEST_CASE("An unmodified document is written back exactly as it was read when preserving the source")
+{
+	const tstring xml = TXT("<?xml version='1.0'?>\n<!DOCTYPE A>\n<A  x = 'a&amp;b' >\n  <B/>\n  <C>t&#65;xt</C><![CDATA[<raw>]]><!-- c -->\n</A>\n");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, XML::Reader::KEEP_SOURCE);
+
+	TEST_TRUE(XML::Writer::writeDocument(document, XML::Writer::PRESERVE_SOURCE) == xml);
+	TEST_TRUE(XML::Writer::writeDocument(document, defaultTestFlags) != xml);
+}
+TEST_CASE_END
+
+TEST_CASE("Only the modified nodes are regenerated when preserving the source")
+{
+	const tstring xml = TXT("<A  x='1'>\n  <B y='2'  />\n  <C z='3'>old</C>\n  <D><E/></D>\n</A>");
+
+	XML::DocumentPtr    document = XML::Reader::readDocument(xml, XML::Reader::KEEP_SOURCE);
+	XML::ElementNodePtr root = document->getRootElement();
+
+	root->findFirstElement(TXT("B"))->setAttribute(TXT("y"), TXT("3"));
+	root->findFirstElement(TXT("C"))->getChild(0)->as<XML::TextNode>()->setText(TXT("<new>"));
+	root->findFirstElement(TXT("D"))->appendChild(XML::makeElement(TXT("F")));
+
+	const tstring expected = TXT("<A  x='1'>\n  <B y=\"3\"/>\n  <C z='3'>&lt;new&gt;</C>\n  <D><E/><F/></D>\n</A>");
+
+	TEST_TRUE(XML::Writer::writeDocument(document, XML::Writer::PRESERVE_SOURCE) == expected);
+}
+TEST_CASE_END
+
+TEST_CASE("setting an attribute's value through the attribute itself is seen by the document")
+{
+	const tstring xml = TXT("<A><B  id='1'/><C id='2'/></A>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml, XML::Reader::KEEP_SOURCE);
+
+	document->enableIdIndex();
+
+	XML::ElementNodePtr b = document->getRootElement()->findFirstElement(TXT("B"));
+
+	TEST_TRUE(document->getElementById(TXT("1")) == b);
+
+	b->getAttributes().find(TXT("id"))->setValue(TXT("3"));
+
+	TEST_TRUE(XML::Writer::writeDocument(document, XML::Writer::PRESERVE_SOURCE) == TXT("<A><B id=\"3\"/><C id='2'/></A>"));
+	TEST_TRUE(document->getElementById(TXT("1")).empty());
+	TEST_TRUE(document->getElementById(TXT("3")) == b);
+}
+TEST_CASE_END
+
+TEST_CASE("A removed subtree doesn't take its source with it")
+{
+	XML::DocumentPtr source = XML::Reader::readDocument(TXT("<A><B  b='1'/></A>"), XML::Reader::KEEP_SOURCE);
+	XML::DocumentPtr target = XML::Reader::readDocument(TXT("<X>.........</X>"), XML::Reader::KEEP_SOURCE);
+	XML::ElementNodePtr node = source->getRootElement()->findFirstElement(TXT("B"));
+
+	source->getRootElement()->removeChild(node);
+	target->getRootElement()->appendChild(node);
+
+	TEST_TRUE(XML::Writer::writeDocument(source, XML::Writer::PRESERVE_SOURCE) == TXT("<A/>"));
+	TEST_TRUE(XML::Writer::writeDocument(target, XML::Writer::PRESERVE_SOURCE) == TXT("<X>.........<B b=\"1\"/></X>"));
+}
+TEST_CASE_END
+
+TEST_CASE("A subtree that outlives its document doesn't keep its source")
+{
+	XML::DocumentPtr    source = XML::Reader::readDocument(TXT("<A><B  b='1'>text</B><!--c--></A>"), XML::Reader::KEEP_SOURCE);
+	XML::DocumentPtr    target = XML::Reader::readDocument(TXT("<X>   some other text here</X>"), XML::Reader::KEEP_SOURCE);
+	XML::ElementNodePtr node = source->getRootElement();
+
+	source.reset();
+
+	TEST_FALSE(node->hasSource());
+
+	target->getRootElement()->appendChild(node);
+
+	TEST_TRUE(XML::Writer::writeDocument(target, XML::Writer::PRESERVE_SOURCE) == TXT("<X>   some other text here<A><B b=\"1\">text</B><!--c--></A></X>"));
+}
+TEST_CASE_END
+
+TEST_CASE("The measured length of a document is the length of its output")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(TXT("<?xml version='1.0'?><A x='&lt;'><B>t&amp;t</B><![CDATA[c]]><!--c--><C/></A>"));
+	const uint       flagSets[] = { XML::Writer::DEFAULT, XML::Writer::NO_FORMATTING };
+
+	for (size_t i = 0; i != ARRAY_SIZE(flagSets); ++i)
+	{
+		const tstring expected = XML::Writer::writeDocument(document, flagSets[i]);
+
+		TEST_TRUE(XML::Writer::measure(document, flagSets[i]) == expected.length());
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("A document can be written into a fixed size array")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(TXT("<A><B>text</B></A>"));
+	const tstring    expected = XML::Writer::writeDocument(document, defaultTestFlags);
+	tchar            array[64];
+
+	const size_t length = XML::Writer::writeTo(document, array, ARRAY_SIZE(array), defaultTestFlags);
+
+	TEST_TRUE(length == expected.length());
+	TEST_TRUE(tstring(array, array+length) == expected);
+}
+TEST_CASE_END
+
+TEST_CASE("Output that doesn't fit into a fixed size array is truncated")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(TXT("<A><B>text</B></A>"));
+	const tstring    expected = XML::Writer::writeDocument(document, defaultTestFlags);
+	tchar            array[8] = { 0 };
+
+	const size_t length = XML::Writer::writeTo(document, array, 5, defaultTestFlags);
+
+	TEST_TRUE(length == expected.length());
+	TEST_TRUE(tstring(array, array+5) == expected.substr(0, 5));
+	TEST_TRUE(array[5] == TXT('\0'));
+}
+TEST_CASE_END
+
+TEST_CASE("Streaming to an invalid file descriptor throws")
+{
+	XML::DocumentPtr    document = XML::makeDocument(XML::makeElement(TXT("root")));
+	XML::DescriptorSink sink(-1);
+
+	TEST_THROWS(XML::Writer::writeDocument(document, sink, defaultTestFlags));
+}
+TEST_CASE_END
+
+TEST_CASE("The partitions of a document joined in order are the same as the whole document")
+{
+	const tchar* xml = TXT("<?xml version=\"1.0\"?><!--head--><root a=\"1\"><x/><y>v</y><z><w/></z><!--c--><x/></root><!--tail-->");
+	const uint   flagSets[] = { XML::Writer::DEFAULT, XML::Writer::NO_FORMATTING };
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	for (size_t i = 0; i != ARRAY_SIZE(flagSets); ++i)
+	{
+		const tstring expected = XML::Writer::writeDocument(document, flagSets[i]);
+
+		for (size_t partitions = 1; partitions != 8; ++partitions)
+		{
+			tstring output;
+
+			for (size_t partition = 0; partition != partitions; ++partition)
+				output += XML::Writer::writePartition(*document, partition, partitions, flagSets[i]);
+
+			TEST_TRUE(output == expected);
+		}
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("The partitions of a large mixed document joined in order are byte-for-byte the whole document")
+{
+	const tchar* children[] =
+	{
+		TXT("<item id=\"1\" q=\"&quot;a&amp;b&quot;\"><name>x &lt; y</name><tags><t/><t/></tags></item>"),
+		TXT("text &amp; more"),
+		TXT("<![CDATA[raw <data>]]>"),
+		TXT("<!--note-->"),
+		TXT("<?pi a=\"1\"?>"),
+		TXT("<deep><a><b><c>v</c></b></a></deep>"),
+		TXT("<empty/>"),
+	};
+	const uint   flagSets[] = { XML::Writer::DEFAULT, XML::Writer::NO_FORMATTING };
+
+	tstring xml = TXT("<?xml version=\"1.0\"?><!DOCTYPE root><!--head--><root a=\"&lt;1&gt;\">");
+
+	for (size_t i = 0; i != 50; ++i)
+		xml += children[i % ARRAY_SIZE(children)];
+
+	xml += TXT("</root><!--tail--><?end?>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	for (size_t i = 0; i != ARRAY_SIZE(flagSets); ++i)
+	{
+		const tstring expected = XML::Writer::writeDocument(document, flagSets[i]);
+
+		// Include more partitions than children, which leaves some empty.
+		for (size_t partitions = 1; partitions != 64; ++partitions)
+		{
+			tstring output;
+
+			for (size_t partition = 0; partition != partitions; ++partition)
+				output += XML::Writer::writePartition(*document, partition, partitions, flagSets[i]);
+
+			TEST_TRUE(output == expected);
+		}
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("A document that can't be partitioned is written by the first partition")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(TXT("<root>text</root>"));
+
+	TEST_TRUE(XML::Writer::writePartition(*document, 0, 2, defaultTestFlags) == TXT("<root>text</root>"));
+	TEST_TRUE(XML::Writer::writePartition(*document, 1, 2, defaultTestFlags) == TXT(""));
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
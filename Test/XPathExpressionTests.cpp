@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathExpressionTests.cpp
+//! \brief  The unit tests for the XPathExpression class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/XPathExpression.hpp>
+#include <XML/XPathIterator.hpp>
+#include <XML/XPathEvaluator.hpp>
+#include <XML/Reader.hpp>
+
+TEST_SET(XPathExpression)
+{
+	const tstring xml = TXT("<A><B ID='1'/><C><B ID='2'/></C><B ID='3'/></A>");
+
+TEST_CASE("default construction creates an expression that matches nothing")
+{
+	XML::DocumentPtr       document = XML::Reader::readDocument(xml);
+	XML::XPathExpression   expression;
+	XML::Nodes             results;
+
+	expression.evaluate(document, results);
+
+	TEST_TRUE(expression.query().empty());
+	TEST_TRUE(expression.stepCount() == 0);
+	TEST_TRUE(results.empty());
+}
+TEST_CASE_END
+
+TEST_CASE("a query is compiled into a sequence of location steps")
+{
+	XML::XPathExpression expression(TXT("/A/C/B"));
+
+	TEST_TRUE(expression.query() == TXT("/A/C/B"));
+	TEST_TRUE(expression.isAbsolute());
+	TEST_TRUE(expression.stepCount() == 3);
+	TEST_TRUE(expression.stepAxis(0) == XML::XPathExpression::CHILD);
+	TEST_TRUE(expression.stepName(0) == TXT("A"));
+	TEST_TRUE(expression.stepName(2) == TXT("B"));
+}
+TEST_CASE_END
+
+TEST_CASE("a query starting with '//' searches the entire document")
+{
+	XML::XPathExpression expression(TXT("//B"));
+
+	TEST_TRUE(expression.isAbsolute());
+	TEST_TRUE(expression.stepCount() == 1);
+	TEST_TRUE(expression.stepAxis(0) == XML::XPathExpression::DESCENDANT);
+}
+TEST_CASE_END
+
+TEST_CASE("a '//' separator selects the descendants of the context node")
+{
+	XML::XPathExpression relative(TXT(".//B"));
+	XML::XPathExpression nested(TXT("A//B/C"));
+
+	TEST_FALSE(relative.isAbsolute());
+	TEST_TRUE(relative.stepCount() == 1);
+	TEST_TRUE(relative.stepAxis(0) == XML::XPathExpression::DESCENDANT);
+	TEST_TRUE(nested.stepCount() == 3);
+	TEST_TRUE(nested.stepAxis(0) == XML::XPathExpression::CHILD);
+	TEST_TRUE(nested.stepAxis(1) == XML::XPathExpression::DESCENDANT);
+	TEST_TRUE(nested.stepAxis(2) == XML::XPathExpression::CHILD);
+}
+TEST_CASE_END
+
+TEST_CASE("a location step can be filtered by predicates and a position")
+{
+	XML::XPathExpression expression(TXT("//trade[@type='x'][ book = \"ldn\" ][@id][2]"));
+
+	TEST_TRUE(expression.stepCount() == 1);
+	TEST_TRUE(expression.stepName(0) == TXT("trade"));
+	TEST_TRUE(expression.stepPosition(0) == 2);
+	TEST_TRUE(expression.predicateCount(0) == 3);
+	TEST_TRUE(expression.predicateType(0, 0) == XML::XPathExpression::ATTRIBUTE_EQUALS);
+	TEST_TRUE(expression.predicateName(0, 0) == TXT("type"));
+	TEST_TRUE(expression.predicateValue(0, 0) == TXT("x"));
+	TEST_TRUE(expression.predicateType(0, 1) == XML::XPathExpression::CHILD_EQUALS);
+	TEST_TRUE(expression.predicateName(0, 1) == TXT("book"));
+	TEST_TRUE(expression.predicateValue(0, 1) == TXT("ldn"));
+	TEST_TRUE(expression.predicateType(0, 2) == XML::XPathExpression::HAS_ATTRIBUTE);
+	TEST_TRUE(expression.predicateName(0, 2) == TXT("id"));
+}
+TEST_CASE_END
+
+TEST_CASE("compiling an invalid predicate throws an exception")
+{
+	TEST_THROWS(XML::XPathExpression(TXT("A[")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[0]")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[@]")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[@id='1]")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[@id=1]")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[name]")));
+	TEST_THROWS(XML::XPathExpression(TXT("A[1][@id]")));
+}
+TEST_CASE_END
+
+TEST_CASE("compiling a query with an empty step throws an exception rather than matching nothing")
+{
+	TEST_THROWS(XML::XPathExpression(TXT("A/")));
+	TEST_THROWS(XML::XPathExpression(TXT("A///B")));
+	TEST_THROWS(XML::XPathExpression(TXT("//")));
+}
+TEST_CASE_END
+
+TEST_CASE("a failed compilation leaves the existing expression unchanged")
+{
+	XML::XPathExpression expression(TXT("/A/B"));
+
+	TEST_THROWS(expression.compile(TXT("A/")));
+
+	TEST_TRUE(expression.query() == TXT("/A/B"));
+	TEST_TRUE(expression.stepCount() == 2);
+	TEST_TRUE(expression.stepName(1) == TXT("B"));
+}
+TEST_CASE_END
+
+TEST_CASE("a compiled expression can be evaluated against many documents")
+{
+	XML::XPathExpression expression(TXT("/A/B"));
+
+	for (size_t i = 0; i != 3; ++i)
+	{
+		XML::DocumentPtr document = XML::Reader::readDocument(xml);
+		XML::Nodes       results;
+
+		expression.evaluate(document, results);
+
+		TEST_TRUE(results.size() == 2);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("an iterator can be constructed from a compiled expression")
+{
+	XML::DocumentPtr     document = XML::Reader::readDocument(xml);
+	XML::XPathExpression expression(TXT("A/C/B"));
+	XML::XPathIterator   it(expression, document);
+	XML::XPathIterator   end;
+
+	TEST_TRUE(it != end);
+
+	XML::ElementNodePtr element = Core::dynamic_ptr_cast<XML::ElementNode>(*it);
+
+	TEST_TRUE(element->getAttributes().find(TXT("ID"))->value() == TXT("2"));
+
+	++it;
+
+	TEST_TRUE(it == end);
+}
+TEST_CASE_END
+
+TEST_CASE("a repeat query against an unchanged document uses the cached results")
+{
+	XML::DocumentPtr     document = XML::Reader::readDocument(xml);
+	XML::XPathExpression expression(TXT("//C/B"));
+	XML::Nodes           first, second, cached;
+
+	document->enableQueryCache();
+
+	expression.evaluate(document, first);
+
+	TEST_TRUE(document->findQueryResults(expression.query(), document.get(), cached));
+	TEST_TRUE(cached == first);
+
+	expression.evaluate(document, second);
+
+	TEST_TRUE(second == first);
+
+	Core::dynamic_ptr_cast<XML::ElementNode>(first[0]->parent())->appendChild(XML::makeElement(TXT("B")));
+	second.clear();
+
+	expression.evaluate(document, second);
+
+	TEST_TRUE(second.size() == first.size()+1);
+}
+TEST_CASE_END
+
+TEST_CASE("the partitions of an evaluation together give the same results in the same order")
+{
+	const tstring wide = TXT("<R><!--c--><A><B ID='1'/><B ID='2'><B ID='3'/></B>text<B ID='4' T='x'/><C><B ID='5'/></C>")
+						 TXT("<B ID='6'/><C><B ID='7'/><B ID='8'/></C><B ID='9'/></A></R>");
+	const tchar* queries[] = { TXT("/"), TXT("/R"), TXT("//A"), TXT("/R/A/B"), TXT("//B"), TXT("//C/B"),
+							   TXT("/R/A/B[2]"), TXT("//B[@T='x']"), TXT("/R//C"), TXT("X") };
+
+	XML::DocumentPtr document = XML::Reader::readDocument(wide);
+
+	for (size_t q = 0; q != ARRAY_SIZE(queries); ++q)
+	{
+		XML::XPathExpression expression(queries[q]);
+		XML::Nodes           expected;
+
+		expression.evaluate(document, expected);
+
+		for (size_t partitions = 1; partitions != 12; ++partitions)
+		{
+			XML::Nodes results;
+
+			for (size_t partition = 0; partition != partitions; ++partition)
+				expression.evaluate(document, partition, partitions, results);
+
+			TEST_TRUE(results == expected);
+		}
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("partitions evaluated side by side into separate results merge into the unpartitioned results")
+{
+	const tstring wide = TXT("<R><A ID='1'><B ID='2'/><B ID='3'><B ID='4'/></B><C><B ID='5'/></C><B ID='6' T='x'/></A></R>");
+	const tchar* queries[] = { TXT("/R/A/B"), TXT("//B"), TXT("//B[@T='x']"), TXT("/R/A/B[2]"), TXT("//A") };
+	const size_t partitions = 3;
+
+	XML::DocumentPtr document = XML::Reader::readDocument(wide);
+
+	for (size_t q = 0; q != ARRAY_SIZE(queries); ++q)
+	{
+		XML::XPathExpression expression(queries[q]);
+		XML::Nodes           expected;
+
+		expression.evaluate(document, expected);
+
+		XML::XPathEvaluator evaluators[partitions];
+		XML::Nodes          results[partitions];
+		bool                finished[partitions] = { false };
+		size_t              remaining = partitions;
+
+		for (size_t p = 0; p != partitions; ++p)
+			evaluators[p].start(expression, document.get(), p, partitions);
+
+		// Take one match from each partition in turn, as threads would.
+		while (remaining != 0)
+		{
+			for (size_t p = 0; p != partitions; ++p)
+			{
+				if (finished[p])
+					continue;
+
+				const XML::Node* node = evaluators[p].next();
+
+				if (node != nullptr)
+				{
+					results[p].push_back(XML::NodePtr(const_cast<XML::Node*>(node), true));
+				}
+				else
+				{
+					finished[p] = true;
+					--remaining;
+				}
+			}
+		}
+
+		XML::Nodes merged;
+
+		for (size_t p = 0; p != partitions; ++p)
+			merged.insert(merged.end(), results[p].begin(), results[p].end());
+
+		TEST_TRUE(merged == expected);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("the work is split amongst the children of the first node with more than one child element")
+{
+	const tstring wide = TXT("<R><A><B/><B/><B/><B/></A></R>");
+
+	XML::DocumentPtr     document = XML::Reader::readDocument(wide);
+	XML::XPathExpression expression(TXT("/R/A/B"));
+
+	for (size_t partition = 0; partition != 4; ++partition)
+	{
+		XML::Nodes results;
+
+		expression.evaluate(document, partition, 4, results);
+
+		TEST_TRUE(results.size() == 1);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("a positional step only selects the nth matching element amongst its siblings")
+{
+	XML::DocumentPtr     document = XML::Reader::readDocument(TXT("<R><A/><B/><A/><A/></R>"));
+	XML::XPathExpression expression(TXT("/R/A[2]"));
+
+	const XML::ElementNodePtr root = document->getRootElement();
+
+	size_t matches = 0;
+	size_t selected = 0;
+
+	for (XML::NodeContainer::const_iterator it = root->beginChild(); it != root->endChild(); ++it)
+	{
+		if (expression.selectsStep(1, *(*it)->as<XML::ElementNode>(), matches))
+			++selected;
+	}
+
+	TEST_TRUE(matches == 3);
+	TEST_TRUE(selected == 1);
+	TEST_FALSE(expression.selectsStep(0, *root->getChild<XML::ElementNode>(0), matches));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
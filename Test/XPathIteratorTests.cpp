@@ -130,5 +130,167 @@ TEST_CASE("an XPath expression uses '/' characters to separate elements")
 }
 TEST_CASE_END
 
+TEST_CASE("a lazy iterator returns the same sequence as an eager one")
+{
+	const tchar* queries[] = { TXT("/"), TXT("A"), TXT("B"), TXT("/A/B"), TXT("/A/C/B"), TXT("//B"), TXT("//C/B"), TXT("X") };
+
+	for (size_t i = 0; i != ARRAY_SIZE(queries); ++i)
+	{
+		XML::XPathIterator eager(queries[i], s_document->getRootElement());
+		XML::XPathIterator lazy(queries[i], s_document->getRootElement(), XML::XPathIterator::LAZY);
+		XML::XPathIterator end;
+
+		for (; eager != end; ++eager, ++lazy)
+		{
+			TEST_TRUE(lazy != end);
+			TEST_TRUE(*lazy == *eager);
+		}
+
+		TEST_TRUE(lazy == end);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("a lazy iterator keeps the whole tree alive for an absolute query")
+{
+	XML::ElementNodePtr context = s_document->getRootElement()->findFirstElement(TXT("C"));
+	XML::XPathIterator  it(TXT("//B"), context, XML::XPathIterator::LAZY);
+	XML::XPathIterator  end;
+
+	s_document.reset();
+	context.reset();
+
+	size_t count = 0;
+
+	for (; it != end; ++it)
+		++count;
+
+	TEST_TRUE(count == 3);
+}
+TEST_CASE_END
+
+TEST_CASE("a lazy iterator with no matches is initialised to the end of the sequence")
+{
+	XML::XPathExpression expression(TXT("/A/C/X"));
+	XML::XPathIterator   it(expression, s_document, XML::XPathIterator::LAZY);
+	XML::XPathIterator   end;
+
+	TEST_TRUE(it == end);
+	TEST_THROWS(*it);
+	TEST_THROWS(++it);
+}
+TEST_CASE_END
+
+TEST_CASE("the XPath expression '//ELEMENT' returns all elements of the same name in document order")
+{
+	XML::XPathIterator it(TXT("//B"), s_document->getRootElement());
+	XML::XPathIterator end;
+
+	const tchar* expected[] = { TXT("2.1"), TXT("3"), TXT("2.3") };
+
+	for (size_t i = 0; i != ARRAY_SIZE(expected); ++i, ++it)
+	{
+		TEST_TRUE(it != end);
+
+		XML::ElementNodePtr element = Core::dynamic_ptr_cast<XML::ElementNode>(*it);
+
+		TEST_TRUE(element->getAttributes().find(TXT("ID"))->value() == expected[i]);
+	}
+
+	TEST_TRUE(it == end);
+}
+TEST_CASE_END
+
+TEST_CASE("the XPath expression './/ELEMENT' returns all descendants of the context of the same name")
+{
+	XML::XPathIterator it(TXT(".//B"), s_document->getRootElement()->findFirstElement(TXT("C")));
+	XML::XPathIterator end;
+
+	XML::ElementNodePtr element = Core::dynamic_ptr_cast<XML::ElementNode>(*it);
+
+	TEST_TRUE(element->getAttributes().find(TXT("ID"))->value() == TXT("3"));
+
+	++it;
+
+	TEST_TRUE(it == end);
+}
+TEST_CASE_END
+
+TEST_CASE("the elements matched by a step can be filtered by predicates")
+{
+	const tstring xml = TXT("<T>")
+						TXT("<trade id='1' type='x'><book>ldn</book></trade>")
+						TXT("<trade id='2' type='y'><book>nyc</book></trade>")
+						TXT("<trade id='3' type='x'><book>nyc</book></trade>")
+						TXT("<trade type='x'><book>ldn</book></trade>")
+						TXT("</T>");
+
+	const tchar* queries[]  = { TXT("//trade[@id='2']"), TXT("/T/trade[@type='x'][2]"), TXT("//trade[book='nyc']"),
+								TXT("T/trade[@type='x'][@id]"), TXT("//trade[3]"), TXT("//trade[@id='4']") };
+	const tchar* expected[] = { TXT("2"),                TXT("3"),                      TXT("23"),
+								TXT("13"),                      TXT("3"),          TXT("") };
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+		if (i == 1)
+		{
+			document->enableNameIndex();
+			document->enableAttributeIndex(TXT("id"));
+		}
+
+		for (size_t q = 0; q != ARRAY_SIZE(queries); ++q)
+		{
+			tstring actual;
+
+			for (XML::XPathIterator it(queries[q], document), end; it != end; ++it)
+				actual += Core::dynamic_ptr_cast<XML::ElementNode>(*it)->getAttributes().find(TXT("id"))->value();
+
+			TEST_TRUE(actual == expected[q]);
+		}
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("a position selects the nth match amongst the siblings of each parent")
+{
+	const tstring xml = TXT("<X><Y ID='a'/><Z><Y ID='b'/><Y ID='c'/></Z><Y ID='d'/></X>");
+
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+	tstring          actual;
+
+	for (XML::XPathIterator it(TXT("//Y[2]"), document), end; it != end; ++it)
+		actual += Core::dynamic_ptr_cast<XML::ElementNode>(*it)->getAttributes().find(TXT("ID"))->value();
+
+	TEST_TRUE(actual == TXT("cd"));
+}
+TEST_CASE_END
+
+TEST_CASE("descendant queries return nested matches once and in document order")
+{
+	const tstring xml = TXT("<X><Y><Y><Z ID='a'/></Y><Z ID='b'/></Y><Z ID='c'/></X>");
+
+	const tchar* queries[]  = { TXT("//Y/Z"), TXT("//Y//Z"), TXT("X//Y/Z"), TXT("/X/Y//Z"), TXT("//Z") };
+	const tchar* expected[] = { TXT("ab"),    TXT("ab"),     TXT("ab"),     TXT("ab"),      TXT("abc") };
+	const uint   flags[]    = { XML::Reader::DEFAULT, XML::Reader::BUILD_NAME_INDEX };
+
+	for (size_t f = 0; f != ARRAY_SIZE(flags); ++f)
+	{
+		XML::DocumentPtr document = XML::Reader::readDocument(xml, flags[f]);
+
+		for (size_t q = 0; q != ARRAY_SIZE(queries); ++q)
+		{
+			tstring actual;
+
+			for (XML::XPathIterator it(queries[q], document, XML::XPathIterator::LAZY), end; it != end; ++it)
+				actual += Core::dynamic_ptr_cast<XML::ElementNode>(*it)->getAttributes().find(TXT("ID"))->value();
+
+			TEST_TRUE(actual == expected[q]);
+		}
+	}
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathQuerySetTests.cpp
+//! \brief  The unit tests for the XPathQuerySet class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/XPathQuerySet.hpp>
+#include <XML/XPathIterator.hpp>
+#include <XML/Reader.hpp>
+
+TEST_SET(XPathQuerySet)
+{
+	const tstring xml = TXT("<A><B ID='1'/><C><B ID='2'/><B ID='3'/></C><B ID='4' T='x'/></A>");
+
+TEST_CASE("an empty query set produces no results")
+{
+	XML::DocumentPtr            document = XML::Reader::readDocument(xml);
+	XML::XPathQuerySet          queries;
+	XML::XPathQuerySet::Results results;
+
+	queries.evaluate(document, results);
+
+	TEST_TRUE(queries.queryCount() == 0);
+	TEST_TRUE(results.empty());
+}
+TEST_CASE_END
+
+TEST_CASE("queries that start with the same steps share the same states")
+{
+	XML::XPathQuerySet queries;
+
+	queries.add(TXT("/A/C/B"));
+	queries.add(TXT("/A/C"));
+	queries.add(TXT("/A/B"));
+	queries.add(TXT("A/B"));
+
+	TEST_TRUE(queries.queryCount() == 4);
+	TEST_TRUE(queries.stateCount() == (2 + 4 + 2));
+}
+TEST_CASE_END
+
+TEST_CASE("a query that fails to compile is not added")
+{
+	XML::XPathQuerySet queries;
+
+	TEST_THROWS(queries.add(TXT("A/")));
+	TEST_TRUE(queries.queryCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("every query produces the same results as when evaluated alone")
+{
+	const tchar* queries[] = { TXT("/"), TXT("/A/B"), TXT("//B"), TXT("A/C/B"), TXT("//C/B[2]"),
+							   TXT("//B[@T='x']"), TXT("/A//B"), TXT("X"), TXT("") };
+
+	XML::DocumentPtr            document = XML::Reader::readDocument(xml);
+	XML::XPathQuerySet          set;
+	XML::XPathQuerySet::Results results;
+
+	for (size_t i = 0; i != ARRAY_SIZE(queries); ++i)
+		TEST_TRUE(set.add(queries[i]) == i);
+
+	set.evaluate(document, results);
+
+	TEST_TRUE(results.size() == ARRAY_SIZE(queries));
+
+	for (size_t i = 0; i != ARRAY_SIZE(queries); ++i)
+	{
+		XML::Nodes expected;
+
+		set.query(i).evaluate(document, expected);
+
+		TEST_TRUE(results[i] == expected);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("relative queries are evaluated from the context node")
+{
+	XML::DocumentPtr            document = XML::Reader::readDocument(xml);
+	XML::XPathQuerySet          queries;
+	XML::XPathQuerySet::Results results;
+
+	queries.add(TXT("B"));
+	queries.add(TXT("/A/B"));
+
+	queries.evaluate(document->getRootElement()->findFirstElement(TXT("C")), results);
+
+	TEST_TRUE(results[0].size() == 2);
+	TEST_TRUE(results[1].size() == 2);
+	TEST_TRUE(Core::dynamic_ptr_cast<XML::ElementNode>(results[0][0])->getAttributeValue(TXT("ID")) == TXT("2"));
+	TEST_TRUE(Core::dynamic_ptr_cast<XML::ElementNode>(results[1][0])->getAttributeValue(TXT("ID")) == TXT("1"));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
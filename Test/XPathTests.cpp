@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathTests.cpp
+//! \brief  The unit tests for the XPath class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <XML/XPath.hpp>
+#include <XML/Reader.hpp>
+
+TEST_SET(XPath)
+{
+	const tstring xml = TXT("<A><B ID='1'/><C><B ID='2'/><B ID='3'/></C><B ID='4' T='x'/></A>");
+
+TEST_CASE("exists returns true only when the query has a match")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	TEST_TRUE(XML::XPath::exists(TXT("//B"), document));
+	TEST_TRUE(XML::XPath::exists(TXT("/"), document));
+	TEST_FALSE(XML::XPath::exists(TXT("//X"), document));
+	TEST_FALSE(XML::XPath::exists(TXT("B"), XML::NodePtr()));
+}
+TEST_CASE_END
+
+TEST_CASE("count returns the number of nodes that match the query")
+{
+	XML::DocumentPtr     document = XML::Reader::readDocument(xml);
+	XML::XPathExpression expression(TXT("//B"));
+
+	TEST_TRUE(XML::XPath::count(expression, document) == 4);
+	TEST_TRUE(XML::XPath::count(TXT("/A/C/B"), document) == 2);
+	TEST_TRUE(XML::XPath::count(TXT("//B[@T='x']"), document) == 1);
+	TEST_TRUE(XML::XPath::count(TXT("//X"), document) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("predicates using an attribute index see attributes changed directly")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(TXT("<A><B k='1'/><B k='2'/><B/></A>"));
+
+	document->enableNameIndex();
+	document->enableAttributeIndex(TXT("k"));
+
+	XML::ElementNodePtr root = document->getRootElement();
+
+	TEST_TRUE(XML::XPath::count(TXT("//B[@k='1']"), document) == 1);
+
+	root->getChild<XML::ElementNode>(1)->getAttributes().set(TXT("k"), TXT("1"));
+	root->getChild<XML::ElementNode>(2)->getAttributes().set(XML::makeAttribute(TXT("k"), TXT("1")));
+
+	TEST_TRUE(XML::XPath::count(TXT("//B[@k='1']"), document) == 3);
+
+	root->getChild<XML::ElementNode>(2)->getAttributes().clear();
+
+	TEST_TRUE(XML::XPath::count(TXT("//B[@k='1']"), document) == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("first returns the first match in document order or null if there are none")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	XML::ElementNodePtr element = Core::dynamic_ptr_cast<XML::ElementNode>(XML::XPath::first(TXT("//C/B"), document));
+
+	TEST_TRUE(element->getAttributeValue(TXT("ID")) == TXT("2"));
+	TEST_TRUE(XML::XPath::first(TXT("//X"), document).empty());
+}
+TEST_CASE_END
+
+TEST_CASE("an invalid query throws")
+{
+	XML::DocumentPtr document = XML::Reader::readDocument(xml);
+
+	TEST_THROWS(XML::XPath::exists(TXT("A/"), document));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
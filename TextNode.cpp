@@ -13,7 +13,8 @@ namespace XML
 //! Default constructor.
 
 TextNode::TextNode()
-	: m_text()
+	: Node(NODE_TYPE)
+	, m_text()
 {
 }
 
@@ -21,7 +22,8 @@ TextNode::TextNode()
 //! Construction from the text string.
 
 TextNode::TextNode(const tstring& text_)
-	: m_text(text_)
+	: Node(NODE_TYPE)
+	, m_text(text_)
 {
 }
 
@@ -22,6 +22,9 @@ namespace XML
 class TextNode : public Node
 {
 public:
+	//! The type of the node.
+	static const NodeType NODE_TYPE = TEXT_NODE;
+
 	//! Default constructor.
 	TextNode();
 
@@ -32,9 +35,6 @@ public:
 	// Properties
 	//
 
-	//! Get the real type of the node.
-	virtual NodeType type() const;
-
 	//! Get the text string.
 	const tstring& text() const;
 
@@ -54,14 +54,6 @@ private:
 //! The default TextNode smart-pointer type.
 typedef Core::RefCntPtr<TextNode> TextNodePtr;
 
-////////////////////////////////////////////////////////////////////////////////
-//! Get the real type of the node.
-
-inline NodeType TextNode::type() const
-{
-	return TEXT_NODE;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the text string.
 
@@ -76,6 +68,8 @@ inline const tstring& TextNode::text() const
 inline void TextNode::setText(const tstring& text_)
 {
 	m_text = text_;
+
+	notifyModified();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
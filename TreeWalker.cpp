@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TreeWalker.cpp
+//! \brief  The TreeWalker class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "TreeWalker.hpp"
+#include "Document.hpp"
+#include "ElementNode.hpp"
+#include "TextNode.hpp"
+#include "CommentNode.hpp"
+#include "ProcessingNode.hpp"
+#include "DocTypeNode.hpp"
+#include "CDataNode.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+TreeWalker::TreeWalker()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+TreeWalker::~TreeWalker()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Walk the tree rooted at the node. Returns false if the visitor stopped the
+//! walk early.
+
+bool TreeWalker::walk(const Node& root, NodeVisitor& visitor)
+{
+	const Node* node = &root;
+
+	for (;;)
+	{
+		const NodeVisitor::Action action = enter(*node, visitor);
+
+		if (action == NodeVisitor::STOP)
+			return false;
+
+		const NodeContainer* container = NodeContainer::fromNode(node);
+
+		if (container != nullptr)
+		{
+			// Descend into the children?
+			if ( (action != NodeVisitor::SKIP_CHILDREN) && (container->hasChildren()) )
+			{
+				node = container->firstChild().get();
+				continue;
+			}
+
+			if (leave(*node, visitor) == NodeVisitor::STOP)
+				return false;
+		}
+
+		// Find the next node, leaving any containers that are now complete.
+		for (;;)
+		{
+			if (node == &root)
+				return true;
+
+			const Node* next = node->nextSibling().get();
+
+			if (next != nullptr)
+			{
+				node = next;
+				break;
+			}
+
+			node = node->parentNode();
+
+			ASSERT(node != nullptr);
+
+			if (leave(*node, visitor) == NodeVisitor::STOP)
+				return false;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Walk the tree rooted at the node. Returns false if the visitor stopped the
+//! walk early.
+
+bool TreeWalker::walkTree(const Node& root, NodeVisitor& visitor)
+{
+	TreeWalker walker;
+
+	return walker.walk(root, visitor);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Invoke the callback for entering or visiting a node.
+
+NodeVisitor::Action TreeWalker::enter(const Node& node, NodeVisitor& visitor)
+{
+	switch (node.type())
+	{
+		case DOCUMENT_NODE:		return visitor.enterDocument(static_cast<const Document&>(node));
+		case ELEMENT_NODE:		return visitor.enterElement(static_cast<const ElementNode&>(node));
+		case TEXT_NODE:			return visitor.visitText(static_cast<const TextNode&>(node));
+		case COMMENT_NODE:		return visitor.visitComment(static_cast<const CommentNode&>(node));
+		case PROCESSING_NODE:	return visitor.visitProcessing(static_cast<const ProcessingNode&>(node));
+		case DOCTYPE_NODE:		return visitor.visitDocType(static_cast<const DocTypeNode&>(node));
+		case CDATA_NODE:		return visitor.visitCData(static_cast<const CDataNode&>(node));
+		default:				ASSERT_FALSE();
+	}
+
+	return NodeVisitor::CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Invoke the callback for leaving a container node.
+
+NodeVisitor::Action TreeWalker::leave(const Node& node, NodeVisitor& visitor)
+{
+	switch (node.type())
+	{
+		case DOCUMENT_NODE:		return visitor.leaveDocument(static_cast<const Document&>(node));
+		case ELEMENT_NODE:		return visitor.leaveElement(static_cast<const ElementNode&>(node));
+		case TEXT_NODE:
+		case COMMENT_NODE:
+		case PROCESSING_NODE:
+		case DOCTYPE_NODE:
+		case CDATA_NODE:
+		default:				ASSERT_FALSE();
+	}
+
+	return NodeVisitor::CONTINUE;
+}
+
+//namespace XML
+}
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TreeWalker.hpp
+//! \brief  The TreeWalker class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_TREEWALKER_HPP
+#define XML_TREEWALKER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Node.hpp"
+#include "NodeVisitor.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The class used to walk a tree of nodes in document order, invoking a typed
+//! callback on a NodeVisitor for each node. The walk is iterative and climbs
+//! back out of the container nodes through their children's parent links,
+//! rather than recursing or keeping a stack, so that it's safe with documents
+//! of any depth and allocates nothing.
+
+class TreeWalker /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	TreeWalker();
+
+	//! Destructor.
+	~TreeWalker();
+
+	//
+	// Methods.
+	//
+
+	//! Walk the tree rooted at the node.
+	bool walk(const Node& root, NodeVisitor& visitor);
+
+	//
+	// Class methods.
+	//
+
+	//! Walk the tree rooted at the node.
+	static bool walkTree(const Node& root, NodeVisitor& visitor);
+
+private:
+	//
+	// Internal methods.
+	//
+
+	//! Invoke the callback for entering or visiting a node.
+	static NodeVisitor::Action enter(const Node& node, NodeVisitor& visitor);
+
+	//! Invoke the callback for leaving a container node.
+	static NodeVisitor::Action leave(const Node& node, NodeVisitor& visitor);
+
+	// NotCopyable.
+	TreeWalker(const TreeWalker&);
+	TreeWalker& operator=(const TreeWalker);
+};
+
+//namespace XML
+}
+
+#endif // XML_TREEWALKER_HPP
@@ -5,12 +5,100 @@
 
 #include "Common.hpp"
 #include "Writer.hpp"
-#include <Core/StringUtils.hpp>
 #include <XML/TextNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <XML/DocTypeNode.hpp>
+#include <XML/CDataNode.hpp>
 
 namespace XML
 {
 
+////////////////////////////////////////////////////////////////////////////////
+//! The visitor used to estimate the size of the output for a document, so that
+//! the buffer can be allocated up front rather than grown as it's written.
+//! The estimate assumes every element is written on its own lines.
+
+class SizeEstimator : public NodeVisitor /*, private NotCopyable*/
+{
+public:
+	//! Constructor.
+	SizeEstimator(size_t indentLength, size_t terminatorLength)
+		: m_indentLength(indentLength)
+		, m_terminatorLength(terminatorLength)
+		, m_depth(0)
+		, m_size(0)
+	{
+	}
+
+	//! Add the tags and attributes of an element.
+	virtual Action enterElement(const ElementNode& element)
+	{
+		const size_t formatting = (m_depth * m_indentLength) + m_terminatorLength;
+
+		m_size += (element.name().length() * 2) + 5 + (formatting * 2);
+
+		Attributes::const_iterator it = element.getAttributes().begin();
+		Attributes::const_iterator end = element.getAttributes().end();
+
+		for (; it != end; ++it)
+			m_size += (*it)->name().length() + (*it)->value().length() + 4;
+
+		++m_depth;
+
+		return CONTINUE;
+	}
+
+	//! Leave an element.
+	virtual Action leaveElement(const ElementNode& /*element*/)
+	{
+		--m_depth;
+
+		return CONTINUE;
+	}
+
+	//! Add the text.
+	virtual Action visitText(const TextNode& text)
+	{
+		m_size += text.text().length();
+
+		return CONTINUE;
+	}
+
+	//! Get the estimated size.
+	size_t size() const
+	{
+		return m_size;
+	}
+
+private:
+	//
+	// Members.
+	//
+	size_t	m_indentLength;		//!< The length of the indentation style.
+	size_t	m_terminatorLength;	//!< The length of the line terminator.
+	size_t	m_depth;			//!< The current element depth.
+	size_t	m_size;				//!< The estimated size.
+
+	// NotCopyable.
+	SizeEstimator(const SizeEstimator&);
+	SizeEstimator& operator=(const SizeEstimator);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an elements value is written inline with its tags, which is when
+//! it's a single text node or CDATA section.
+
+static bool isInlineValue(const ElementNode& element)
+{
+	if (element.getChildCount() != 1)
+		return false;
+
+	const NodeType type = element.firstChild()->type();
+
+	return ( (type == TEXT_NODE) || (type == CDATA_NODE) );
+}
+
 //! The default indentation style.
 const tchar* Writer::DEFAULT_INDENT_STYLE = TXT("\t");
 
@@ -22,9 +110,10 @@ const tchar* Writer::DEFAULT_TERMINATOR = TXT("\n");
 
 Writer::Writer()
 	: m_flags(DEFAULT)
-	, m_indentStyle(DEFAULT_INDENT_STYLE)
-	, m_buffer()
+	, m_output(true, DEFAULT_INDENT_STYLE, DEFAULT_TERMINATOR)
+	, m_source(nullptr)
 	, m_depth(0)
+	, m_walker()
 {
 }
 
@@ -33,9 +122,10 @@ Writer::Writer()
 
 Writer::Writer(uint flags, const tchar* indentStyle)
 	: m_flags(flags)
-	, m_indentStyle(indentStyle)
-	, m_buffer()
+	, m_output(((flags & (NO_FORMATTING|PRESERVE_SOURCE)) == 0), indentStyle, DEFAULT_TERMINATOR)
+	, m_source(nullptr)
 	, m_depth(0)
+	, m_walker()
 {
 }
 
@@ -47,58 +137,268 @@ Writer::~Writer()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Write a document to a string buffer.
+//! Write a document to the buffer, and then to the sink if streaming.
 
-tstring Writer::formatDocument(DocumentPtr document)
+void Writer::formatDocument(DocumentPtr document)
 {
 	ASSERT(document.get() != nullptr);
 
-	m_buffer.clear();
+	useSource(*document);
+
+	if (m_output.isBuffered())
+		m_output.reserve(estimateSize(*document));
 
-	writeContainer(*document.get());
+	m_walker.walk(*document, *this);
 
 	ASSERT(m_depth == 0);
 
-	return m_buffer;
+	m_output.flush();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Write a document to a string buffer.
+//! Write one partition of a document to the buffer. The root element's children
+//! are split into contiguous ranges, with the first partition also writing the
+//! nodes before them and the last the nodes after them. A document that can't
+//! be split, including one whose root element is copied from the source, is
+//! written entirely by the first partition.
+
+void Writer::formatPartition(const Document& document, size_t partition, size_t partitions)
+{
+	ASSERT(partition < partitions);
+
+	useSource(document);
+
+	const Node* root = document.firstChild().get();
+
+	// Find the root element without relying on the document's cached one.
+	while ( (root != nullptr) && (root->type() != ELEMENT_NODE) )
+		root = root->nextSibling().get();
+
+	const ElementNode* element = static_cast<const ElementNode*>(root);
+
+	if ( (element == nullptr) || (!element->hasChildren()) || (isInlineValue(*element))
+	  || ((m_source != nullptr) && (element->hasSource())) )
+	{
+		if (partition == 0)
+		{
+			if (m_output.isBuffered())
+				m_output.reserve(estimateSize(document));
+
+			m_walker.walk(document, *this);
+		}
+
+		return;
+	}
+
+	const size_t count = element->getChildCount();
+	const size_t begin = (count * partition) / partitions;
+	const size_t end   = (count * (partition+1)) / partitions;
+
+	const Node* first = element->firstChild().get();
+
+	for (size_t i = 0; i != begin; ++i)
+		first = first->nextSibling().get();
+
+	const Node* last = first;
+
+	for (size_t i = begin; i != end; ++i)
+		last = last->nextSibling().get();
+
+	if (partition == 0)
+	{
+		formatNodes(document.firstChild().get(), root);
+		enterElement(*element);
+	}
+
+	m_depth = 1;
+	formatNodes(first, last);
+
+	if (partition == partitions-1)
+	{
+		leaveElement(*element);
+		formatNodes(root->nextSibling().get(), nullptr);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a range of sibling nodes to the buffer, ending before the last node.
+
+void Writer::formatNodes(const Node* begin, const Node* end)
+{
+	if (m_output.isBuffered())
+	{
+		size_t size = 0;
+
+		for (const Node* node = begin; node != end; node = node->nextSibling().get())
+			size += estimateSize(*node);
+
+		m_output.reserve(size);
+	}
+
+	for (const Node* node = begin; node != end; node = node->nextSibling().get())
+		m_walker.walk(*node, *this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the source text to copy the unmodified nodes from, if preserving the
+//! source and the document kept it.
+
+void Writer::useSource(const Document& document)
+{
+	if ( ((m_flags & PRESERVE_SOURCE) != 0) && (document.hasSourceText()) )
+		m_source = document.sourceText().data();
+	else
+		m_source = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy a node from the source text to the buffer, if preserving the source
+//! and the node is unmodified. Returns true if the node was copied.
+
+inline bool Writer::copySource(const Node& node)
+{
+	if ( (m_source == nullptr) || (!node.hasSource()) )
+		return false;
+
+	m_output.writeValue(m_source + node.sourceBegin(), node.sourceEnd() - node.sourceBegin());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a document to a string buffer. The buffer is handed over, rather than
+//! copied.
 
 tstring Writer::writeDocument(DocumentPtr document, uint flags, const tchar* indentStyle)
 {
 	XML::Writer writer(flags, indentStyle);
+	tstring     output;
+
+	writer.formatDocument(document);
+	writer.m_output.swap(output);
 
-	return writer.formatDocument(document);
+	return output;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Write a container of nodes to the buffer.
+//! Write a document to an output sink. The output is passed to the sink in
+//! chunks of roughly BUFFER_SIZE characters, which may be exceeded by a
+//! single large node. The large values are referenced, rather than copied, so
+//! the document must not be modified by the sink.
 
-void Writer::writeContainer(const NodeContainer& container)
+void Writer::writeDocument(DocumentPtr document, OutputSink& sink, uint flags, const tchar* indentStyle)
 {
-	XML::NodeContainer::const_iterator it = container.beginChild();
-	XML::NodeContainer::const_iterator end = container.endChild();
+	XML::Writer writer(flags, indentStyle);
 
-	for (; it != end; ++it)
-	{
-		if ((*it)->type() == ELEMENT_NODE)
-		{
-			XML::ElementNodePtr child = Core::dynamic_ptr_cast<XML::ElementNode>(*it);
+	writer.m_output.attach(sink, true);
+	writer.formatDocument(document);
+}
 
-			writeElement(child);
-		}
-		else if ((*it)->type() == TEXT_NODE)
-		{
-			XML::TextNodePtr child = Core::dynamic_ptr_cast<XML::TextNode>(*it);
+////////////////////////////////////////////////////////////////////////////////
+//! Write a document into a fixed size array, returning the length of the
+//! output. If the length exceeds the capacity the output was truncated to
+//! fit. The output is not null terminated.
 
-			m_buffer += child->text();
-		}
-		else
+size_t Writer::writeTo(DocumentPtr document, tchar* array, size_t capacity, uint flags, const tchar* indentStyle)
+{
+	XML::Writer writer(flags, indentStyle);
+
+	writer.m_output.attach(array, capacity);
+	writer.formatDocument(document);
+
+	return writer.m_output.length();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure the exact length of the output for a document, by writing it
+//! without keeping any of it.
+
+size_t Writer::measure(DocumentPtr document, uint flags, const tchar* indentStyle)
+{
+	return writeTo(document, nullptr, 0, flags, indentStyle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write one partition of a document to a string buffer. The output of all the
+//! partitions, joined in partition order, is the same as writing the whole
+//! document. The nodes are reached through the sibling links, which are
+//! returned by reference, and the root element is found by scanning the
+//! document's children rather than through its cached one. So different
+//! partitions of the same document can be written on different threads, as
+//! long as nothing modifies the document until they have all finished.
+
+tstring Writer::writePartition(const Document& document, size_t partition, size_t partitions, uint flags, const tchar* indentStyle)
+{
+	XML::Writer writer(flags, indentStyle);
+	tstring     output;
+
+	writer.formatPartition(document, partition, partitions);
+	writer.m_output.swap(output);
+
+	return output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the buffer to the sink, if streaming and it's full.
+
+NodeVisitor::Action Writer::flushIfFull()
+{
+	m_output.flushIfFull();
+
+	return CONTINUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Estimate the size of the output for a node.
+
+size_t Writer::estimateSize(const Node& node) const
+{
+	SizeEstimator estimator(m_output.indentStyle().length(), m_output.terminator().length());
+
+	TreeWalker::walkTree(node, estimator);
+
+	return estimator.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the indentation for the current depth to the buffer.
+
+inline void Writer::writeIndentation()
+{
+	m_output.writeIndentation(m_depth);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the start tag of an element to the buffer, or the entire element if
+//! it's empty.
+
+void Writer::writeStartTag(const ElementNode& element, bool empty)
+{
+	writeIndentation();
+
+	// Copy an unmodified start tag, unless it was also the end tag.
+	if ( (m_source != nullptr) && (!empty) && (element.hasStartTagSource()) )
+	{
+		const size_t begin = element.sourceBegin();
+		const size_t end = element.startTagSourceEnd();
+
+		if (m_source[end-2] != TXT('/'))
 		{
-			ASSERT_FALSE();
+			m_output.writeValue(m_source + begin, end - begin);
+			return;
 		}
 	}
+
+	m_output.write(TXT("<"), 1);
+	m_output.write(element.name());
+
+	if (!element.getAttributes().isEmpty())
+		writeAttributes(element.getAttributes());
+
+	if (empty)
+		m_output.write(TXT("/>"), 2);
+	else
+		m_output.write(TXT(">"), 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -111,81 +411,170 @@ void Writer::writeAttributes(const Attributes& attributes)
 
 	for (; it != end; ++it)
 	{
-		m_buffer += Core::fmt(TXT(" %s=\"%s\""), (*it)->name().c_str(), (*it)->value().c_str());
+		m_output.write(TXT(" "), 1);
+		m_output.write((*it)->name());
+		m_output.write(TXT("=\""), 2);
+		m_output.writeEscaped((*it)->value(), true);
+		m_output.write(TXT("\""), 1);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Write an element to the buffer.
+//! Write the start tag of an element to the buffer, or the entire element if
+//! it has no children.
 
-void Writer::writeElement(ElementNodePtr element)
+NodeVisitor::Action Writer::enterElement(const ElementNode& element)
 {
-	tstring indentation;
-	tstring terminator;
-
-	if (!(m_flags & NO_FORMATTING))
+	if (copySource(element))
 	{
-		for (uint i = 0; i != m_depth; ++i)
-			indentation += m_indentStyle;
+		m_output.flushIfFull();
 
-		terminator = DEFAULT_TERMINATOR;
+		return SKIP_CHILDREN;
 	}
 
-	if (element->hasChildren())
+	if (element.hasChildren())
 	{
-		const bool inlineValue = ( (element->getChildCount() == 1)
-								&& (element->getChild(0)->type() == TEXT_NODE) );
+		writeStartTag(element, false);
 
-		if (!element->getAttributes().isEmpty())
-		{
-			m_buffer += indentation;
-			m_buffer += Core::fmt(TXT("<%s"), element->name().c_str());
+		if (!isInlineValue(element))
+			m_output.writeTerminator();
 
-			writeAttributes(element->getAttributes());
+		++m_depth;
+	}
+	else
+	{
+		writeStartTag(element, true);
+		m_output.writeTerminator();
+	}
 
-			m_buffer += TXT(">");
+	return flushIfFull();
+}
 
-			if (!inlineValue)
-				m_buffer += terminator;
-		}
-		else
-		{
-			m_buffer += indentation;
-			m_buffer += Core::fmt(TXT("<%s>"), element->name().c_str());
+////////////////////////////////////////////////////////////////////////////////
+//! Write the end tag of an element to the buffer.
 
-			if (!inlineValue)
-				m_buffer += terminator;
-		}
+NodeVisitor::Action Writer::leaveElement(const ElementNode& element)
+{
+	// Written as an empty tag or copied?
+	if ( (!element.hasChildren()) || ((m_source != nullptr) && (element.hasSource())) )
+		return CONTINUE;
 
-		++m_depth;
-		writeContainer(*element);
-		--m_depth;
+	--m_depth;
 
-		if (!inlineValue)
-			m_buffer += indentation;
+	if (!isInlineValue(element))
+		writeIndentation();
 
-		m_buffer += Core::fmt(TXT("</%s>"), element->name().c_str());
-		m_buffer += terminator;
-	}
-	else
-	{
-		if (!element->getAttributes().isEmpty())
-		{
-			m_buffer += indentation;
-			m_buffer += Core::fmt(TXT("<%s"), element->name().c_str());
+	m_output.write(TXT("</"), 2);
+	m_output.write(element.name());
+	m_output.write(TXT(">"), 1);
+	m_output.writeTerminator();
 
-			writeAttributes(element->getAttributes());
+	return flushIfFull();
+}
 
-			m_buffer += TXT("/>");
-			m_buffer += terminator;
-		}
-		else
-		{
-			m_buffer += indentation;
-			m_buffer += Core::fmt(TXT("<%s/>"), element->name().c_str());
-			m_buffer += terminator;
-		}
+////////////////////////////////////////////////////////////////////////////////
+//! Write a text node to the buffer.
+
+NodeVisitor::Action Writer::visitText(const TextNode& text)
+{
+	if (copySource(text))
+		return flushIfFull();
+
+	m_output.writeEscaped(text.text(), false);
+
+	return flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a comment node to the buffer.
+
+NodeVisitor::Action Writer::visitComment(const CommentNode& comment)
+{
+	if (copySource(comment))
+		return flushIfFull();
+
+	writeIndentation();
+	m_output.write(TXT("<!--"), 4);
+	m_output.writeValue(comment.comment().data(), comment.comment().length());
+	m_output.write(TXT("-->"), 3);
+	m_output.writeTerminator();
+
+	return flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a processing instruction node to the buffer.
+
+NodeVisitor::Action Writer::visitProcessing(const ProcessingNode& processing)
+{
+	if (copySource(processing))
+		return flushIfFull();
+
+	writeIndentation();
+	m_output.write(TXT("<?"), 2);
+	m_output.write(processing.target());
+
+	if (!processing.getAttributes().isEmpty())
+		writeAttributes(processing.getAttributes());
+
+	m_output.write(TXT("?>"), 2);
+	m_output.writeTerminator();
+
+	return flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a document type node to the buffer. The declaration is written as
+//! read, which includes the white-space that follows the DOCTYPE keyword.
+
+NodeVisitor::Action Writer::visitDocType(const DocTypeNode& docType)
+{
+	if (copySource(docType))
+		return flushIfFull();
+
+	const tstring& declaration = docType.declaration();
+
+	writeIndentation();
+	m_output.write(TXT("<!DOCTYPE"), 9);
+
+	if ( (!declaration.empty()) && (!tisspace(static_cast<utchar>(declaration[0]))) )
+		m_output.write(TXT(" "), 1);
+
+	m_output.writeValue(declaration.data(), declaration.length());
+	m_output.write(TXT(">"), 1);
+	m_output.writeTerminator();
+
+	return flushIfFull();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a CDATA section node to the buffer. As a section can't contain its
+//! own terminator, any "]]>" in the text is split across two sections.
+
+NodeVisitor::Action Writer::visitCData(const CDataNode& cdata)
+{
+	if (copySource(cdata))
+		return flushIfFull();
+
+	const tstring& text = cdata.text();
+	size_t         begin = 0;
+	size_t         end = text.find(TXT("]]>"));
+
+	m_output.write(TXT("<![CDATA["), 9);
+
+	while (end != tstring::npos)
+	{
+		m_output.writeValue(text.data()+begin, end+2-begin);
+		m_output.write(TXT("]]><![CDATA["), 12);
+
+		begin = end+2;
+		end = text.find(TXT("]]>"), begin);
 	}
+
+	m_output.writeValue(text.data()+begin, text.length()-begin);
+	m_output.write(TXT("]]>"), 3);
+
+	return flushIfFull();
 }
 
 //namespace XML
@@ -13,14 +13,41 @@
 
 #include "Document.hpp"
 #include "ElementNode.hpp"
+#include "TreeWalker.hpp"
+#include "OutputBuffer.hpp"
 
 namespace XML
 {
 
 ////////////////////////////////////////////////////////////////////////////////
-//! The writer to create a text stream from an XML document.
-
-class Writer /*: private NotCopyable*/
+//! The writer to create a text stream from an XML document. The document is
+//! walked iteratively with a TreeWalker and so is not limited by its depth.
+//!
+//! The output can either be returned as a string or streamed to an OutputSink.
+//! When streaming, the output is passed on each time the buffer fills, so the
+//! memory used is bounded by the buffer size rather than the document size.
+//! Any large values, such as text and CDATA sections, are passed to the sink
+//! by reference rather than copied into the buffer.
+//!
+//! The markup characters in text and attribute values are written as entity
+//! references, and the Reader decodes them again.
+//!
+//! The output can also be written directly into an array supplied by the
+//! caller, with its exact length measured up front if need be. Nothing is
+//! allocated, as the tree is walked through the nodes' own links and the
+//! indentation is written from a static run of white-space.
+//!
+//! A document read with its source text kept can be written by copying the
+//! unmodified nodes from the source, so that only the modified ones are
+//! regenerated and the original formatting is preserved. The regenerated
+//! nodes are then not formatted, as the white-space is part of the text.
+//!
+//! A large document can also be written in partitions, which split the root
+//! element's children into contiguous ranges. The partitions only read the
+//! document and so can be written concurrently, with their output joined in
+//! partition order to give the same output as writing the whole document.
+
+class Writer : private NodeVisitor /*, private NotCopyable*/
 {
 public:
 	//! The writing flags.
@@ -28,6 +55,7 @@ public:
 	{
 		DEFAULT				= 0x0000,	//!< Default flags.
 		NO_FORMATTING		= 0x0001,	//!< Don't pretty print the XML.
+		PRESERVE_SOURCE		= 0x0002,	//!< Copy the unmodified nodes from the source.
 	};
 
 	//! The default indentation style.
@@ -35,6 +63,9 @@ public:
 	
 	//! The default line terminator.
 	static const tchar* DEFAULT_TERMINATOR;
+
+	//! The number of characters buffered before they're written to a sink.
+	static const size_t BUFFER_SIZE = OutputBuffer::BUFFER_SIZE;
 	
 	//
 	// Class methods.
@@ -43,14 +74,27 @@ public:
 	//! Write a document to a string buffer.
 	static tstring writeDocument(DocumentPtr document, uint flags = DEFAULT, const tchar* indentStyle = DEFAULT_INDENT_STYLE);
 
+	//! Write a document to an output sink.
+	static void writeDocument(DocumentPtr document, OutputSink& sink, uint flags = DEFAULT, const tchar* indentStyle = DEFAULT_INDENT_STYLE); // throw(IOException)
+
+	//! Write a document into a fixed size array.
+	static size_t writeTo(DocumentPtr document, tchar* array, size_t capacity, uint flags = DEFAULT, const tchar* indentStyle = DEFAULT_INDENT_STYLE);
+
+	//! Measure the exact length of the output for a document.
+	static size_t measure(DocumentPtr document, uint flags = DEFAULT, const tchar* indentStyle = DEFAULT_INDENT_STYLE);
+
+	//! Write one partition of a document to a string buffer.
+	static tstring writePartition(const Document& document, size_t partition, size_t partitions, uint flags = DEFAULT, const tchar* indentStyle = DEFAULT_INDENT_STYLE);
+
 private:
 	//
 	// Members.
 	//
 	uint			m_flags;		//!< The flags to control writing.
-	tstring			m_indentStyle;	//!< The string to use for indenting.
-	tstring			m_buffer;		//!< The output buffer.
+	OutputBuffer	m_output;		//!< The output buffer.
+	const tchar*	m_source;		//!< The source text to copy nodes from, if preserving it.
 	uint			m_depth;		//!< The indentation depth.
+	TreeWalker		m_walker;		//!< The walker used to traverse the document.
 
 	//
 	// Internal methods.
@@ -65,17 +109,56 @@ private:
 	//! Destructor.
 	~Writer();
 
-	//! Write a document to a string buffer.
-	tstring formatDocument(DocumentPtr document);
+	//! Write a document to the buffer, and the sink if streaming.
+	void formatDocument(DocumentPtr document);
+
+	//! Write one partition of a document to the buffer.
+	void formatPartition(const Document& document, size_t partition, size_t partitions);
+
+	//! Write a range of sibling nodes to the buffer.
+	void formatNodes(const Node* begin, const Node* end);
+
+	//! Set the source text to copy the unmodified nodes from.
+	void useSource(const Document& document);
 
-	//! Write a container of nodes to the buffer.
-	void writeContainer(const NodeContainer& container);
+	//! Copy a node from the source text to the buffer, if it's unmodified.
+	bool copySource(const Node& node);
+
+	//! Write the buffer to the sink, if streaming and it's full.
+	Action flushIfFull();
+
+	//! Write the indentation for the current depth to the buffer.
+	void writeIndentation();
+
+	//! Write the start tag of an element to the buffer.
+	void writeStartTag(const ElementNode& element, bool empty);
 
 	//! Write the attributes to the buffer.
 	void writeAttributes(const Attributes& attributes);
 
-	//! Write an element to the buffer.
-	void writeElement(ElementNodePtr element);
+	//! Estimate the size of the output for a node.
+	size_t estimateSize(const Node& node) const;
+
+	//! Write the start tag of an element to the buffer.
+	virtual Action enterElement(const ElementNode& element);
+
+	//! Write the end tag of an element to the buffer.
+	virtual Action leaveElement(const ElementNode& element);
+
+	//! Write a text node to the buffer.
+	virtual Action visitText(const TextNode& text);
+
+	//! Write a comment node to the buffer.
+	virtual Action visitComment(const CommentNode& comment);
+
+	//! Write a processing instruction node to the buffer.
+	virtual Action visitProcessing(const ProcessingNode& processing);
+
+	//! Write a document type node to the buffer.
+	virtual Action visitDocType(const DocTypeNode& docType);
+
+	//! Write a CDATA section node to the buffer.
+	virtual Action visitCData(const CDataNode& cdata);
 
 	// NotCopyable.
 	Writer(const Writer&);
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPath.cpp
+//! \brief  The XPath class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XPath.hpp"
+#include "XPathEvaluator.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if any nodes match a query.
+
+bool XPath::exists(const tstring& query, const NodePtr& context)
+{
+	return exists(XPathExpression(query), context);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if any nodes match a compiled query. The evaluation stops at the
+//! first match.
+
+bool XPath::exists(const XPathExpression& expression, const NodePtr& context)
+{
+	XPathEvaluator evaluator;
+
+	evaluator.start(expression, context.get());
+
+	return (evaluator.next() != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the nodes that match a query.
+
+size_t XPath::count(const tstring& query, const NodePtr& context)
+{
+	return count(XPathExpression(query), context);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the nodes that match a compiled query. The matches are only counted,
+//! not stored.
+
+size_t XPath::count(const XPathExpression& expression, const NodePtr& context)
+{
+	XPathEvaluator evaluator;
+	size_t         matches = 0;
+
+	evaluator.start(expression, context.get());
+
+	while (evaluator.next() != nullptr)
+		++matches;
+
+	return matches;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first node, in document order, that matches a query.
+
+NodePtr XPath::first(const tstring& query, const NodePtr& context)
+{
+	return first(XPathExpression(query), context);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first node, in document order, that matches a compiled query, or
+//! return null if there are no matches. The evaluation stops at the first
+//! match.
+
+NodePtr XPath::first(const XPathExpression& expression, const NodePtr& context)
+{
+	XPathEvaluator evaluator;
+
+	evaluator.start(expression, context.get());
+
+	const Node* node = evaluator.next();
+
+	if (node == nullptr)
+		return NodePtr();
+
+	return NodePtr(const_cast<Node*>(node), true);
+}
+
+//namespace XML
+}
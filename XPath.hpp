@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPath.hpp
+//! \brief  The XPath class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_XPATH_HPP
+#define XML_XPATH_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "XPathExpression.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The entry points for the XPath queries where only a summary of the matches
+//! is needed. Unlike an XPathIterator no results are stored, the evaluation
+//! stops as soon as the answer is known, and only the node returned by first()
+//! is reference counted.
+
+class XPath
+{
+public:
+	//
+	// Class methods.
+	//
+
+	//! Query if any nodes match a query.
+	static bool exists(const tstring& query, const NodePtr& context); // throw(InvalidArgException)
+
+	//! Query if any nodes match a compiled query.
+	static bool exists(const XPathExpression& expression, const NodePtr& context);
+
+	//! Count the nodes that match a query.
+	static size_t count(const tstring& query, const NodePtr& context); // throw(InvalidArgException)
+
+	//! Count the nodes that match a compiled query.
+	static size_t count(const XPathExpression& expression, const NodePtr& context);
+
+	//! Find the first node, in document order, that matches a query.
+	static NodePtr first(const tstring& query, const NodePtr& context); // throw(InvalidArgException)
+
+	//! Find the first node, in document order, that matches a compiled query.
+	static NodePtr first(const XPathExpression& expression, const NodePtr& context);
+
+private:
+	// Static class.
+	XPath();
+};
+
+//namespace XML
+}
+
+#endif // XML_XPATH_HPP
@@ -0,0 +1,417 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathEvaluator.cpp
+//! \brief  The XPathEvaluator class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XPathEvaluator.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+XPathEvaluator::XPathEvaluator()
+	: m_expression(nullptr)
+	, m_single(nullptr)
+	, m_frames()
+	, m_states()
+	, m_elements(nullptr)
+	, m_index(0)
+	, m_top(nullptr)
+	, m_filter(false)
+	, m_partition(0)
+	, m_partitions(1)
+	, m_split(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+XPathEvaluator::~XPathEvaluator()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start evaluating an expression against a context node. The internal stacks
+//! are retained so that an evaluator can be reused without reallocating.
+
+void XPathEvaluator::start(const XPathExpression& expression, const Node* context)
+{
+	start(expression, context, 0, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start evaluating one partition of an expression against a context node. The
+//! indexes are not used as they would be built on demand. See
+//! XPathExpression::evaluate() for the partitions that can be evaluated
+//! concurrently.
+
+void XPathEvaluator::start(const XPathExpression& expression, const Node* context, size_t partition, size_t partitions)
+{
+	ASSERT(partition < partitions);
+
+	reset();
+
+	if (context == nullptr)
+		return;
+
+	m_expression = &expression;
+
+	if (expression.isAbsolute())
+	{
+		// Search for the document root...
+		while (context->hasParent())
+			context = context->parentNode();
+
+		// The query is just the root?
+		if (expression.stepCount() == 0)
+		{
+			if (partition == 0)
+				m_single = context;
+
+			return;
+		}
+	}
+	else if (expression.stepCount() == 0)
+	{
+		return;
+	}
+
+	m_partition = partition;
+	m_partitions = partitions;
+
+	if (partitions == 1)
+	{
+		if ( (context->type() == DOCUMENT_NODE) && (startFromIndex(*static_cast<const Document*>(context))) )
+			return;
+	}
+	else
+	{
+		m_split = findSplitNode(context);
+	}
+
+	const NodeContainer* nodes = NodeContainer::fromNode(context);
+
+	if (nodes != nullptr)
+	{
+		addState(m_states, 0, 0);
+
+		if (context == m_split)
+			pushSplitFrame(*nodes, 0);
+		else
+			pushFrame(nodes->firstChild().get(), 0, true, (partitions == 1));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the next match, or return null if there are no more.
+
+const Node* XPathEvaluator::next()
+{
+	if (m_single != nullptr)
+	{
+		const Node* node = m_single;
+
+		m_single = nullptr;
+
+		return node;
+	}
+
+	if (m_filter)
+		return nextFilteredElement();
+
+	for (;;)
+	{
+		if ( (m_frames.empty()) && (!startNextElement()) )
+			return nullptr;
+
+		Frame&      frame = m_frames.back();
+		const Node* node = frame.m_next;
+
+		// All children visited?
+		if (node == frame.m_end)
+		{
+			m_states.resize(frame.m_states);
+			m_frames.pop_back();
+			continue;
+		}
+
+		frame.m_next = (frame.m_siblings) ? node->nextSibling().get() : nullptr;
+
+		const bool inside = frame.m_inside;
+
+		if (node->type() != ELEMENT_NODE)
+			continue;
+
+		const ElementNode& element = *static_cast<const ElementNode*>(node);
+		const size_t       last = m_states.size();
+		const bool         matched = advance(*m_expression, m_states, frame.m_states, element);
+
+		const NodeContainer* nodes = &element;
+
+		// Only descend if there is something left to match.
+		if ( (m_states.size() != last) && (nodes->hasChildren()) )
+		{
+			if (node == m_split)
+				pushSplitFrame(*nodes, last);
+			else
+				pushFrame(nodes->firstChild().get(), last, true, inside);
+		}
+		else
+		{
+			m_states.resize(last);
+		}
+
+		// Matches outside the partitioned nodes belong to the first partition.
+		if ( (matched) && ((inside) || (m_partition == 0)) )
+			return node;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Abandon the evaluation.
+
+void XPathEvaluator::reset()
+{
+	m_expression = nullptr;
+	m_single = nullptr;
+	m_frames.clear();
+	m_states.clear();
+	m_elements = nullptr;
+	m_index = 0;
+	m_top = nullptr;
+	m_filter = false;
+	m_partition = 0;
+	m_partitions = 1;
+	m_split = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open a node so that its children are visited next.
+
+void XPathEvaluator::pushFrame(const Node* first, size_t states, bool siblings, bool inside)
+{
+	Frame frame = { first, states, siblings, nullptr, inside };
+
+	m_frames.push_back(frame);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open the node whose children are partitioned, so that only the partition's
+//! share of them is visited next. A step that selects by position counts the
+//! matches across all the siblings, so then the first partition visits them
+//! all instead.
+
+void XPathEvaluator::pushSplitFrame(const NodeContainer& nodes, size_t states)
+{
+	for (size_t i = states; i != m_states.size(); ++i)
+	{
+		if (m_expression->stepPosition(m_states[i].m_step) != 0)
+		{
+			if (m_partition == 0)
+				pushFrame(nodes.firstChild().get(), states, true, true);
+			else
+				m_states.resize(states);
+
+			return;
+		}
+	}
+
+	const size_t count = nodes.getChildCount();
+	const size_t begin = (count * m_partition) / m_partitions;
+	const size_t end   = (count * (m_partition+1)) / m_partitions;
+	const Node*  first = nodes.firstChild().get();
+
+	for (size_t i = 0; i != begin; ++i)
+		first = first->nextSibling().get();
+
+	const Node* last = first;
+
+	for (size_t i = begin; i != end; ++i)
+		last = last->nextSibling().get();
+
+	Frame frame = { first, states, true, last, true };
+
+	m_frames.push_back(frame);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the node whose children are partitioned, which is the first one at or
+//! below the context node that has more than one child element. Returns null
+//! if there is no such node, which leaves everything to the first partition.
+
+const Node* XPathEvaluator::findSplitNode(const Node* node)
+{
+	for (;;)
+	{
+		const NodeContainer* nodes = NodeContainer::fromNode(node);
+
+		if (nodes == nullptr)
+			return nullptr;
+
+		const Node* element = nullptr;
+
+		for (const Node* child = nodes->firstChild().get(); child != nullptr; child = child->nextSibling().get())
+		{
+			if (child->type() != ELEMENT_NODE)
+				continue;
+
+			if (element != nullptr)
+				return node;
+
+			element = child;
+		}
+
+		if (element == nullptr)
+			return nullptr;
+
+		node = element;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start the walk from the next indexed element. Elements nested inside the
+//! last one started from are skipped as the walk below it has already been
+//! done, which is what keeps the matches in document order and unique.
+
+bool XPathEvaluator::startNextElement()
+{
+	if (m_elements == nullptr)
+		return false;
+
+	while (m_index != m_elements->size())
+	{
+		const Node* element = (*m_elements)[m_index++];
+		const Node* ancestor = element->parentNode();
+
+		while ( (ancestor != nullptr) && (ancestor != m_top) )
+			ancestor = ancestor->parentNode();
+
+		if (ancestor == nullptr)
+		{
+			m_top = element;
+
+			m_states.clear();
+			addState(m_states, 0, 0);
+			pushFrame(element, 0, false, true);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start from the elements in an index, if one is suitable. This requires the
+//! first step to search the entire document and not select by position, which
+//! depends on the siblings. If it's the only step, an attribute value index
+//! for one of its predicates will give the fewest elements to filter.
+
+bool XPathEvaluator::startFromIndex(const Document& document)
+{
+	if ( (m_expression->stepAxis(0) != XPathExpression::DESCENDANT)
+	  || (m_expression->stepPosition(0) != 0) )
+	{
+		return false;
+	}
+
+	const bool single = (m_expression->stepCount() == 1);
+
+	if (single)
+	{
+		for (size_t i = 0; i != m_expression->predicateCount(0); ++i)
+		{
+			const tstring& attribute = m_expression->predicateName(0, i);
+
+			if ( (m_expression->predicateType(0, i) == XPathExpression::ATTRIBUTE_EQUALS)
+			  && (document.hasAttributeIndex(attribute)) )
+			{
+				m_elements = &document.elementsByAttribute(attribute, m_expression->predicateValue(0, i));
+				m_filter = true;
+				return true;
+			}
+		}
+	}
+
+	if (document.hasNameIndex())
+	{
+		m_elements = &document.elementsByName(m_expression->stepName(0));
+		m_filter = single;
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the next indexed element that matches the only step, or return null if
+//! there are no more.
+
+const Node* XPathEvaluator::nextFilteredElement()
+{
+	while (m_index != m_elements->size())
+	{
+		const ElementNode* element = (*m_elements)[m_index++];
+
+		if (m_expression->matchesStep(0, *element))
+			return element;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match an element against the set of steps that it and its siblings can
+//! match, which starts at the first state. The steps that the children of the
+//! element can then match are appended as a new set. Returns true if the
+//! element matches the last step of the expression. This is shared with the
+//! stream matcher, which has no tree, only the sets for the open elements.
+
+bool XPathEvaluator::advance(const XPathExpression& expression, States& states, size_t first, const ElementNode& element)
+{
+	const size_t last  = states.size();
+	const size_t steps = expression.stepCount();
+	bool         matched = false;
+
+	for (size_t i = first; i != last; ++i)
+	{
+		const size_t step = states[i].m_step;
+
+		if (expression.stepAxis(step) == XPathExpression::DESCENDANT)
+			addState(states, last, step);
+
+		if (!expression.selectsStep(step, element, states[i].m_matches))
+			continue;
+
+		if (step+1 == steps)
+			matched = true;
+		else
+			addState(states, last, step+1);
+	}
+
+	return matched;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a step to the set being built, which starts at the given offset, if
+//! not already present.
+
+void XPathEvaluator::addState(States& states, size_t begin, size_t step)
+{
+	for (size_t i = begin; i != states.size(); ++i)
+	{
+		if (states[i].m_step == step)
+			return;
+	}
+
+	State state = { step, 0 };
+
+	states.push_back(state);
+}
+
+//namespace XML
+}
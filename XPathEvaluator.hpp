@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathEvaluator.hpp
+//! \brief  The XPathEvaluator class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_XPATHEVALUATOR_HPP
+#define XML_XPATHEVALUATOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Document.hpp"
+#include "XPathExpression.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The engine used to evaluate a compiled XPathExpression. The tree below the
+//! context node is walked once, in document order, using an explicit stack.
+//! Each open element holds the set of location steps that its children could
+//! match next, and a subtree is skipped as soon as that set is empty. As each
+//! node is visited only once the matches are returned in document order with
+//! no duplicates, and matches are only found as they're asked for.
+//!
+//! When the expression starts by searching an entire document that has a
+//! name index, the walk starts from the indexed elements instead. If that is
+//! the only step the indexed elements just need filtering by the predicates,
+//! and an attribute value index is used instead when one matches a predicate.
+//!
+//! The evaluation can also be split into a number of partitions, so that each
+//! one can be evaluated on a separate thread. The walk is split amongst the
+//! children of the first node that has more than one child element, and any
+//! matches above them belong to the first partition. As the partitions are
+//! contiguous runs of siblings, the matches of all the partitions, in order,
+//! are the same as those of an unpartitioned evaluation.
+
+class XPathEvaluator /*: private NotCopyable*/
+{
+public:
+	//! A location step that the children of an open node can match.
+	struct State
+	{
+		size_t		m_step;		//!< The location step.
+		size_t		m_matches;	//!< The number of children matched so far.
+	};
+
+	//! The container type used for the sets of steps. The set for each open
+	//! node follows that of its parent.
+	typedef std::vector<State> States;
+
+	//! Default constructor.
+	XPathEvaluator();
+
+	//! Destructor.
+	~XPathEvaluator();
+
+	//
+	// Methods.
+	//
+
+	//! Start evaluating an expression against a context node.
+	void start(const XPathExpression& expression, const Node* context);
+
+	//! Start evaluating one partition of an expression against a context node.
+	void start(const XPathExpression& expression, const Node* context, size_t partition, size_t partitions);
+
+	//! Find the next match.
+	const Node* next();
+
+	//! Abandon the evaluation.
+	void reset();
+
+	//
+	// Class methods.
+	//
+
+	//! Match an element against the set of steps its siblings can match.
+	static bool advance(const XPathExpression& expression, States& states, size_t first, const ElementNode& element);
+
+	//! Add a step to the set being built, if not already present.
+	static void addState(States& states, size_t begin, size_t step);
+
+private:
+	//! The state of an open node whose children are being visited.
+	struct Frame
+	{
+		const Node*	m_next;		//!< The next child node to visit.
+		size_t		m_states;	//!< The offset of the steps the children can match.
+		bool		m_siblings;	//!< Visit the siblings of the next node?
+		const Node*	m_end;		//!< The child node to stop at.
+		bool		m_inside;	//!< Are the children inside the partition?
+	};
+
+	//! The stack of open nodes.
+	typedef std::vector<Frame> Frames;
+
+	//
+	// Members.
+	//
+	const XPathExpression*		m_expression;	//!< The expression being evaluated.
+	const Node*					m_single;		//!< The single node still to return.
+	Frames						m_frames;		//!< The stack of open nodes.
+	States						m_states;		//!< The sets of steps for the open nodes.
+	const Document::Elements*	m_elements;		//!< The indexed elements to start from.
+	size_t						m_index;		//!< The next indexed element.
+	const Node*					m_top;			//!< The last indexed element started from.
+	bool						m_filter;		//!< Only filter the indexed elements?
+	size_t						m_partition;	//!< The partition being evaluated.
+	size_t						m_partitions;	//!< The number of partitions.
+	const Node*					m_split;		//!< The node whose children are partitioned.
+
+	//
+	// Internal methods.
+	//
+
+	//! Open a node so that its children are visited next.
+	void pushFrame(const Node* first, size_t states, bool siblings, bool inside);
+
+	//! Open the node whose children are partitioned.
+	void pushSplitFrame(const NodeContainer& nodes, size_t states);
+
+	//! Find the node whose children are partitioned.
+	static const Node* findSplitNode(const Node* node);
+
+	//! Start the walk from the next indexed element.
+	bool startNextElement();
+
+	//! Start from the elements in an index, if one is suitable.
+	bool startFromIndex(const Document& document);
+
+	//! Find the next indexed element that matches the only step.
+	const Node* nextFilteredElement();
+
+	// NotCopyable.
+	XPathEvaluator(const XPathEvaluator&);
+	XPathEvaluator& operator=(const XPathEvaluator);
+};
+
+//namespace XML
+}
+
+#endif // XML_XPATHEVALUATOR_HPP
@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathExpression.cpp
+//! \brief  The XPathExpression class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XPathExpression.hpp"
+#include "XPathEvaluator.hpp"
+#include "TextNode.hpp"
+#include <Core/InvalidArgException.hpp>
+#include <Core/StringUtils.hpp>
+#include <algorithm>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Skip any whitespace in the query.
+
+static void skipWhitespace(tstring::const_iterator& it, tstring::const_iterator end)
+{
+	while ( (it != end) && ((*it == TXT(' ')) || (*it == TXT('\t'))) )
+		++it;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the text value of an element, which is the concatenation of its
+//! child text nodes, matches a value.
+
+static bool textEquals(const ElementNode& element, const tstring& value)
+{
+	const Node* first = element.firstChild().get();
+
+	// The common case of a single text node.
+	if ( (first != nullptr) && (first->type() == TEXT_NODE) && (first->nextSibling().get() == nullptr) )
+		return (static_cast<const TextNode*>(first)->text() == value);
+
+	tstring text;
+
+	for (const Node* node = first; node != nullptr; node = node->nextSibling().get())
+	{
+		if (node->type() == TEXT_NODE)
+			text += static_cast<const TextNode*>(node)->text();
+	}
+
+	return (text == value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+XPathExpression::XPathExpression()
+	: m_query()
+	, m_absolute(false)
+	, m_steps()
+	, m_predicates()
+	, m_names()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from a query.
+
+XPathExpression::XPathExpression(const tstring& query_)
+	: m_query()
+	, m_absolute(false)
+	, m_steps()
+	, m_predicates()
+	, m_names()
+{
+	compile(query_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+XPathExpression::~XPathExpression()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compile a query, replacing the current expression. The supported syntax is
+//! a sequence of element names separated by '/' characters. A leading '/'
+//! makes the path absolute and a '//' separator selects the descendants of
+//! the context node rather than just its children. A leading './' or './/'
+//! makes the context node explicit. Each element name can be followed by a
+//! sequence of predicates in square brackets, the last of which may be a
+//! position.
+
+void XPathExpression::compile(const tstring& query_)
+{
+	tstring::const_iterator it  = query_.begin();
+	tstring::const_iterator end = query_.end();
+
+	bool       absolute = false;
+	Steps      steps;
+	Predicates predicates;
+	Names      names;
+
+	// Is an absolute path?
+	if ( (it != end) && (*it == TXT('/')) )
+		absolute = true;
+	// Is an explicit context node?
+	else if ( (it != end) && (*it == TXT('.')) && ((it+1) != end) && (*(it+1) == TXT('/')) )
+		++it;
+
+	// Until the entire query has been parsed.
+	while (it != end)
+	{
+		Axis axis = CHILD;
+
+		// Skip the path separator.
+		if (*it == TXT('/'))
+		{
+			++it;
+
+			// Is a search of all descendants?
+			if ( (it != end) && (*it == TXT('/')) )
+			{
+				axis = DESCENDANT;
+				++it;
+			}
+		}
+
+		// Extract the element name.
+		tstring::const_iterator nameFirst = it;
+
+		while ( (it != end) && (*it != TXT('/')) && (*it != TXT('[')) )
+			++it;
+
+		if (nameFirst == it)
+		{
+			// A lone '/' is the document root.
+			if ( (steps.empty()) && (axis == CHILD) && (it == end) && (absolute) )
+				break;
+
+			throw Core::InvalidArgException(Core::fmt(TXT("Invalid XPath expression '%s'"), query_.c_str()));
+		}
+
+		Step step = { axis, intern(names, tstring(nameFirst, it)), predicates.size(), 0, 0 };
+
+		// Parse any predicates.
+		while ( (it != end) && (*it == TXT('[')) )
+		{
+			if (step.m_position != 0)
+				throw Core::InvalidArgException(Core::fmt(TXT("Unsupported XPath expression '%s'"), query_.c_str()));
+
+			++it;
+
+			parsePredicate(query_, it, step, predicates, names);
+		}
+
+		steps.push_back(step);
+	}
+
+	m_query = query_;
+	m_absolute = absolute;
+	m_steps.swap(steps);
+	m_predicates.swap(predicates);
+	m_names.swap(names);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Evaluate the expression against a context node, appending the matching
+//! nodes to the results in document order. If the document caches query
+//! results, a repeat query against an unchanged document is a lookup.
+
+void XPathExpression::evaluate(const NodePtr& context, Nodes& results) const
+{
+	const Document* document = (context.get() != nullptr) ? context->ownerDocument() : nullptr;
+
+	if ( (document == nullptr) || (!document->hasQueryCache()) )
+	{
+		evaluateNodes(context.get(), results);
+		return;
+	}
+
+	// An absolute query has the same results for any context.
+	const Node* key = (m_absolute) ? document : context.get();
+
+	if (document->findQueryResults(m_query, key, results))
+		return;
+
+	Nodes matches;
+
+	evaluateNodes(context.get(), matches);
+	document->cacheQueryResults(m_query, key, matches);
+
+	results.insert(results.end(), matches.begin(), matches.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Evaluate one partition of the expression against a context node, appending
+//! the matching nodes to the results in document order. The results of every
+//! partition, appended in partition order, are the same as those from a
+//! single evaluation.
+//!
+//! This is the only evaluation that may be run on more than one thread at a
+//! time, one partition per thread with its own results, against the same
+//! expression and context. A partition follows the tree through raw pointers
+//! and looks up attributes without taking a reference, so the only reference
+//! counts it changes are those of the nodes it returns, and no node is
+//! returned by more than one partition. It doesn't use the document's indexes
+//! or query cache, which are built and filled on demand. The context must be
+//! a NodePtr the caller already holds, as converting a DocumentPtr or
+//! ElementNodePtr to one takes a reference. The document must not be modified,
+//! nor any other query run against it, until all the partitions have finished.
+
+void XPathExpression::evaluate(const NodePtr& context, size_t partition, size_t partitions, Nodes& results) const
+{
+	ASSERT(partition < partitions);
+
+	XPathEvaluator evaluator;
+
+	evaluator.start(*this, context.get(), partition, partitions);
+
+	for (const Node* node = evaluator.next(); node != nullptr; node = evaluator.next())
+		results.push_back(NodePtr(const_cast<Node*>(node), true));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Evaluate the expression against a context node, appending the matching
+//! nodes to the results in document order.
+
+void XPathExpression::evaluateNodes(const Node* context, Nodes& results) const
+{
+	XPathEvaluator evaluator;
+
+	evaluator.start(*this, context);
+
+	for (const Node* node = evaluator.next(); node != nullptr; node = evaluator.next())
+		results.push_back(NodePtr(const_cast<Node*>(node), true));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an element matches the name and predicates of a location step.
+//! The position, if any, is not tested as it depends on the elements siblings.
+
+bool XPathExpression::matchesStep(size_t index, const ElementNode& element) const
+{
+	ASSERT(index < m_steps.size());
+
+	const Step& step = m_steps[index];
+
+	if (element.name() != m_names[step.m_name])
+		return false;
+
+	for (size_t i = 0; i != step.m_count; ++i)
+	{
+		const Predicate& predicate = m_predicates[step.m_predicates + i];
+		const tstring&   name = m_names[predicate.m_name];
+		const tstring&   value = m_names[predicate.m_value];
+
+		switch (predicate.m_type)
+		{
+			case HAS_ATTRIBUTE:
+			{
+				if (element.getAttributes().findValue(name) == nullptr)
+					return false;
+			}
+			break;
+
+			case ATTRIBUTE_EQUALS:
+			{
+				const tstring* attribute = element.getAttributes().findValue(name);
+
+				if ( (attribute == nullptr) || (*attribute != value) )
+					return false;
+			}
+			break;
+
+			case CHILD_EQUALS:
+			{
+				bool found = false;
+
+				for (const Node* node = element.firstChild().get(); (node != nullptr) && !found; node = node->nextSibling().get())
+				{
+					found = (node->type() == ELEMENT_NODE)
+						 && (static_cast<const ElementNode*>(node)->name() == name)
+						 && (textEquals(*static_cast<const ElementNode*>(node), value));
+				}
+
+				if (!found)
+					return false;
+			}
+			break;
+
+			default:
+				ASSERT_FALSE();
+			break;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an element, as one of a run of siblings, is selected by a location
+//! step. For a step that selects by position the matching siblings are
+//! counted, so the count must start at zero for each run.
+
+bool XPathExpression::selectsStep(size_t index, const ElementNode& element, size_t& matches) const
+{
+	if (!matchesStep(index, element))
+		return false;
+
+	const size_t position = stepPosition(index);
+
+	// Is the nth match amongst its siblings?
+	return ( (position == 0) || (++matches == position) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a name to the set of interned names, returning its index.
+
+size_t XPathExpression::intern(Names& names, const tstring& name)
+{
+	Names::const_iterator it = std::find(names.begin(), names.end(), name);
+
+	if (it != names.end())
+		return (it - names.begin());
+
+	names.push_back(name);
+
+	return names.size()-1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a predicate, up to and including the closing ']', and add it to the
+//! location step.
+
+void XPathExpression::parsePredicate(const tstring& query_, tstring::const_iterator& it, Step& step, Predicates& predicates, Names& names)
+{
+	const tstring::const_iterator end = query_.end();
+
+	skipWhitespace(it, end);
+
+	// Is a position?
+	if ( (it != end) && (*it >= TXT('0')) && (*it <= TXT('9')) )
+	{
+		size_t position = 0;
+
+		while ( (it != end) && (*it >= TXT('0')) && (*it <= TXT('9')) )
+			position = (position * 10) + (*it++ - TXT('0'));
+
+		skipWhitespace(it, end);
+
+		if ( (position == 0) || (it == end) || (*it != TXT(']')) )
+			throw Core::InvalidArgException(Core::fmt(TXT("Invalid XPath predicate in '%s'"), query_.c_str()));
+
+		++it;
+
+		step.m_position = position;
+		return;
+	}
+
+	PredicateType type = CHILD_EQUALS;
+
+	// Is an attribute test?
+	if ( (it != end) && (*it == TXT('@')) )
+	{
+		type = HAS_ATTRIBUTE;
+		++it;
+	}
+
+	// Extract the attribute or element name.
+	tstring::const_iterator nameFirst = it;
+
+	while ( (it != end) && (*it != TXT(' ')) && (*it != TXT('\t')) && (*it != TXT('=')) && (*it != TXT(']')) )
+		++it;
+
+	tstring::const_iterator nameLast = it;
+
+	skipWhitespace(it, end);
+
+	tstring::const_iterator valueFirst = it;
+	tstring::const_iterator valueLast = it;
+
+	// Is an equality test?
+	if ( (it != end) && (*it == TXT('=')) )
+	{
+		++it;
+		skipWhitespace(it, end);
+
+		if ( (it == end) || ((*it != TXT('\'')) && (*it != TXT('"'))) )
+			throw Core::InvalidArgException(Core::fmt(TXT("Invalid XPath predicate in '%s'"), query_.c_str()));
+
+		const tchar quote = *it++;
+
+		valueFirst = it;
+
+		while ( (it != end) && (*it != quote) )
+			++it;
+
+		if (it == end)
+			throw Core::InvalidArgException(Core::fmt(TXT("Invalid XPath predicate in '%s'"), query_.c_str()));
+
+		valueLast = it++;
+
+		skipWhitespace(it, end);
+
+		if (type == HAS_ATTRIBUTE)
+			type = ATTRIBUTE_EQUALS;
+	}
+	else if (type == CHILD_EQUALS)
+	{
+		throw Core::InvalidArgException(Core::fmt(TXT("Unsupported XPath predicate in '%s'"), query_.c_str()));
+	}
+
+	if ( (nameFirst == nameLast) || (it == end) || (*it != TXT(']')) )
+		throw Core::InvalidArgException(Core::fmt(TXT("Invalid XPath predicate in '%s'"), query_.c_str()));
+
+	++it;
+
+	Predicate predicate = { type, intern(names, tstring(nameFirst, nameLast)), intern(names, tstring(valueFirst, valueLast)) };
+
+	predicates.push_back(predicate);
+	++step.m_count;
+}
+
+//namespace XML
+}
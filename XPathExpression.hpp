@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathExpression.hpp
+//! \brief  The XPathExpression class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_XPATHEXPRESSION_HPP
+#define XML_XPATHEXPRESSION_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Node.hpp"
+#include "NodeContainer.hpp"
+
+namespace XML
+{
+
+// Forward declarations.
+class ElementNode;
+
+////////////////////////////////////////////////////////////////////////////////
+//! An XPath expression that has been compiled into a sequence of location
+//! steps. The query is only parsed once and each distinct element name is
+//! stored just once, so that the same expression can be evaluated against
+//! many contexts or documents without any further parsing or allocations
+//! other than for the results. The expression is evaluated by an
+//! XPathEvaluator.
+//!
+//! A step can be filtered by predicates on the elements attributes, e.g.
+//! [@id] or [@id='42'], or on the text of a child element, e.g. [name='v'],
+//! followed by an optional position, e.g. [2], which selects the nth element
+//! matched amongst its siblings.
+
+class XPathExpression
+{
+public:
+	//! The axis used to select the nodes for a step.
+	enum Axis
+	{
+		CHILD,			//!< The child elements of the context node.
+		DESCENDANT,		//!< All descendant elements of the context node.
+	};
+
+	//! The type of test a predicate applies.
+	enum PredicateType
+	{
+		HAS_ATTRIBUTE,		//!< The element has the attribute.
+		ATTRIBUTE_EQUALS,	//!< The elements attribute has the value.
+		CHILD_EQUALS,		//!< A child element has the text value.
+	};
+
+	//! Default constructor.
+	XPathExpression();
+
+	//! Construction from a query.
+	explicit XPathExpression(const tstring& query); // throw(InvalidArgException)
+
+	//! Destructor.
+	~XPathExpression();
+
+	//
+	// Properties.
+	//
+
+	//! Get the query the expression was compiled from.
+	const tstring& query() const;
+
+	//! Query if the expression is evaluated from the document root.
+	bool isAbsolute() const;
+
+	//! Get the number of location steps.
+	size_t stepCount() const;
+
+	//! Get the axis for a location step.
+	Axis stepAxis(size_t index) const;
+
+	//! Get the element name for a location step.
+	const tstring& stepName(size_t index) const;
+
+	//! Get the position a location step selects, or 0 if any.
+	size_t stepPosition(size_t index) const;
+
+	//! Get the number of predicates for a location step.
+	size_t predicateCount(size_t index) const;
+
+	//! Get the type of a location step predicate.
+	PredicateType predicateType(size_t index, size_t predicate) const;
+
+	//! Get the attribute or child element name a location step predicate tests.
+	const tstring& predicateName(size_t index, size_t predicate) const;
+
+	//! Get the value a location step predicate tests for.
+	const tstring& predicateValue(size_t index, size_t predicate) const;
+
+	//
+	// Methods.
+	//
+
+	//! Compile a query, replacing the current expression.
+	void compile(const tstring& query); // throw(InvalidArgException)
+
+	//! Evaluate the expression against a context node.
+	void evaluate(const NodePtr& context, Nodes& results) const;
+
+	//! Evaluate one partition of the expression against a context node.
+	void evaluate(const NodePtr& context, size_t partition, size_t partitions, Nodes& results) const;
+
+	//! Query if an element matches the name and predicates of a location step.
+	bool matchesStep(size_t index, const ElementNode& element) const;
+
+	//! Query if an element, as one of a run of siblings, is selected by a step.
+	bool selectsStep(size_t index, const ElementNode& element, size_t& matches) const;
+
+private:
+	//! A compiled location step.
+	struct Step
+	{
+		Axis	m_axis;			//!< The axis to select nodes from.
+		size_t	m_name;			//!< The index of the interned element name.
+		size_t	m_predicates;	//!< The index of the first predicate.
+		size_t	m_count;		//!< The number of predicates.
+		size_t	m_position;		//!< The position to select, or 0 if any.
+	};
+
+	//! A compiled predicate.
+	struct Predicate
+	{
+		PredicateType	m_type;		//!< The type of test.
+		size_t			m_name;		//!< The index of the interned name.
+		size_t			m_value;	//!< The index of the interned value.
+	};
+
+	//! The container type used for the location steps.
+	typedef std::vector<Step> Steps;
+	//! The container type used for the predicates.
+	typedef std::vector<Predicate> Predicates;
+	//! The container type used for the interned element names.
+	typedef std::vector<tstring> Names;
+
+	//
+	// Members.
+	//
+	tstring		m_query;		//!< The source query.
+	bool		m_absolute;		//!< Is evaluated from the document root?
+	Steps		m_steps;		//!< The location steps.
+	Predicates	m_predicates;	//!< The predicates for all the steps.
+	Names		m_names;		//!< The interned names and values.
+
+	//
+	// Internal methods.
+	//
+
+	//! Add a name to the set of interned names.
+	static size_t intern(Names& names, const tstring& name);
+
+	//! Get a location step predicate.
+	const Predicate& predicate(size_t index, size_t predicate) const;
+
+	//! Evaluate the expression against a context node, without using a cache.
+	void evaluateNodes(const Node* context, Nodes& results) const;
+
+	//! Parse a predicate and add it to the location step.
+	static void parsePredicate(const tstring& query, tstring::const_iterator& it, Step& step, Predicates& predicates, Names& names); // throw(InvalidArgException)
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the query the expression was compiled from.
+
+inline const tstring& XPathExpression::query() const
+{
+	return m_query;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the expression is evaluated from the document root.
+
+inline bool XPathExpression::isAbsolute() const
+{
+	return m_absolute;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of location steps.
+
+inline size_t XPathExpression::stepCount() const
+{
+	return m_steps.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the axis for a location step.
+
+inline XPathExpression::Axis XPathExpression::stepAxis(size_t index) const
+{
+	ASSERT(index < m_steps.size());
+
+	return m_steps[index].m_axis;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the element name for a location step.
+
+inline const tstring& XPathExpression::stepName(size_t index) const
+{
+	ASSERT(index < m_steps.size());
+
+	return m_names[m_steps[index].m_name];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the position a location step selects, or 0 if any.
+
+inline size_t XPathExpression::stepPosition(size_t index) const
+{
+	ASSERT(index < m_steps.size());
+
+	return m_steps[index].m_position;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of predicates for a location step. This excludes any
+//! position.
+
+inline size_t XPathExpression::predicateCount(size_t index) const
+{
+	ASSERT(index < m_steps.size());
+
+	return m_steps[index].m_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the type of a location step predicate.
+
+inline XPathExpression::PredicateType XPathExpression::predicateType(size_t index, size_t predicate_) const
+{
+	return predicate(index, predicate_).m_type;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the attribute or child element name a location step predicate tests.
+
+inline const tstring& XPathExpression::predicateName(size_t index, size_t predicate_) const
+{
+	return m_names[predicate(index, predicate_).m_name];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value a location step predicate tests for.
+
+inline const tstring& XPathExpression::predicateValue(size_t index, size_t predicate_) const
+{
+	return m_names[predicate(index, predicate_).m_value];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a location step predicate.
+
+inline const XPathExpression::Predicate& XPathExpression::predicate(size_t index, size_t predicate_) const
+{
+	ASSERT(index < m_steps.size());
+	ASSERT(predicate_ < m_steps[index].m_count);
+
+	return m_predicates[m_steps[index].m_predicates + predicate_];
+}
+
+//namespace XML
+}
+
+#endif // XML_XPATHEXPRESSION_HPP
@@ -14,23 +14,50 @@ namespace XML
 //! Default constructor.
 
 XPathIterator::XPathIterator()
-	: m_query()
-	, m_context()
-	, m_results()
+	: m_results()
 	, m_currNode(m_results.end())
+	, m_mode(EAGER)
+	, m_compiled()
+	, m_root()
+	, m_evaluator()
+	, m_current()
 {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Construction from a query and a document.
 
-XPathIterator::XPathIterator(const tstring& query, const NodePtr& context)
-	: m_query(query)
-	, m_context(context)
-	, m_results()
+XPathIterator::XPathIterator(const tstring& query, const NodePtr& context, Mode mode)
+	: m_results()
 	, m_currNode(m_results.end())
+	, m_mode(mode)
+	, m_compiled(query)
+	, m_root()
+	, m_evaluator()
+	, m_current()
 {
-	start();
+	if (m_mode == LAZY)
+		startLazy(m_compiled, context);
+	else
+		start(m_compiled, context);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from a compiled query and a context node.
+
+XPathIterator::XPathIterator(const XPathExpression& expression, const NodePtr& context, Mode mode)
+	: m_results()
+	, m_currNode(m_results.end())
+	, m_mode(mode)
+	, m_compiled()
+	, m_root()
+	, m_evaluator()
+	, m_current()
+{
+	if (m_mode == LAZY)
+		startLazy(expression, context);
+	else
+		start(expression, context);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,10 +73,10 @@ XPathIterator::~XPathIterator()
 
 NodePtr XPathIterator::operator*() const
 {
-	if (m_currNode == m_results.end())
+	if (atEnd())
 		throw Core::BadLogicException(TXT("Attempt to dereference an invalid XPath iterator"));
 
-	return *m_currNode;
+	return (m_mode == LAZY) ? m_current : *m_currNode;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -69,35 +96,15 @@ XPathIterator& XPathIterator::operator++()
 
 bool XPathIterator::equals(const XPathIterator& rhs) const
 {
-	return ( (m_currNode     == m_results.end())
-		  && (rhs.m_currNode == rhs.m_results.end()) );
+	return (atEnd() && rhs.atEnd());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Start the iteration.
 
-void XPathIterator::start()
+void XPathIterator::start(const XPathExpression& expression, const NodePtr& context)
 {
-	tstring::const_iterator it  = m_query.begin();
-	tstring::const_iterator end = m_query.end();
-
-	NodePtr context = m_context;
-
-	// Until the entire query has been parsed.
-	if (it != end)
-	{
-		// Is an absolute path?
-		if (*it == TXT('/'))
-		{
-			++it;
-
-			// Search for the document root...
-			while (context->hasParent())
-				context = context->parent();
-		}
-
-		parse(it, end, context);
-	}
+	expression.evaluate(context, m_results);
 
 	// Start iterating the result set.
 	m_currNode = m_results.begin();
@@ -108,10 +115,13 @@ void XPathIterator::start()
 
 void XPathIterator::next()
 {
-	if (m_currNode == m_results.end())
+	if (atEnd())
 		throw Core::BadLogicException(TXT("Attempted to advance an invalid XPath iterator"));
 
-	++m_currNode;
+	if (m_mode == LAZY)
+		findNext();
+	else
+		++m_currNode;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -119,62 +129,50 @@ void XPathIterator::next()
 
 void XPathIterator::reset()
 {
-	m_query.clear();
-	m_context.reset();
 	m_results.clear();
 	m_currNode = m_results.end();
+	m_evaluator.reset();
+	m_current.reset();
+	m_root.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start the lazy iteration by finding the first match. A reference is held on
+//! the root of the context node's tree, rather than the context node, as an
+//! absolute query is evaluated from the root. This keeps the whole tree alive
+//! whilst it's being evaluated.
+
+void XPathIterator::startLazy(const XPathExpression& expression, const NodePtr& context)
+{
+	m_root = context;
+
+	// Search for the document root...
+	while ( (m_root.get() != nullptr) && (m_root->hasParent()) )
+		m_root = m_root->parent();
+
+	m_evaluator.start(expression, context.get());
+	findNext();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the next lazy match.
+
+void XPathIterator::findNext()
+{
+	const Node* node = m_evaluator.next();
+
+	m_current = NodePtr(const_cast<Node*>(node), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Parse the next part of the query.
+//! Query if the iterator is at the end of the sequence.
 
-void XPathIterator::parse(QueryIterator begin, QueryIterator end, const NodePtr& context)
+bool XPathIterator::atEnd() const
 {
-	// Finished parsing?
-	if (begin == end)
-	{
-		// Add to results, if valid node.
-		if (context.get() != nullptr)
-			m_results.push_back(context);
-
-		return;
-	}
-
-	// Skip path separator.
-	tstring::const_iterator it = begin;
-
-	if (*it == TXT('/'))
-		++it;
-
-	// Extract the node name.
-	tstring::const_iterator nameFirst = it;
-
-	while ( (it != end) && (*it != TXT('/')) )
-		++it;
-
-	tstring name(nameFirst, it);
-
-	NodeType       type  = context->type();
-	NodeContainer* nodes = nullptr;
-
-	// Has children?
-	if (type == DOCUMENT_NODE)
-		nodes = Core::static_ptr_cast<Document>(context).get();
-	else if (type == ELEMENT_NODE)
-		nodes = Core::static_ptr_cast<ElementNode>(context).get();
-
-	// Find all children that match the name.
-	for (NodeContainer::const_iterator nodeIter = nodes->beginChild(); nodeIter != nodes->endChild(); ++nodeIter)
-	{
-		const NodePtr& node = *nodeIter;
-
-		// If a match, recurse...
-		if ( (node->type() == ELEMENT_NODE)
-			&& (Core::static_ptr_cast<ElementNode>(node)->name() == name) )
-		{
-			parse(it, end, *nodeIter);
-		}
-	}
+	if (m_mode == LAZY)
+		return (m_current.get() == nullptr);
+
+	return (m_currNode == m_results.end());
 }
 
 //namespace XML
@@ -12,23 +12,43 @@
 #endif
 
 #include "Document.hpp"
+#include "XPathExpression.hpp"
+#include "XPathEvaluator.hpp"
 
 namespace XML
 {
 
 ////////////////////////////////////////////////////////////////////////////////
 //! An iterator for enumerating an XML document according to an XPath
-//! expression. To keep the code simple the iterator runs the entire query up
-//! front and just iterates the results.
+//! expression. To keep the code simple the iterator, by default, runs the
+//! entire query up front and just iterates the results. An iterator can be
+//! constructed from a compiled XPathExpression to avoid parsing the query each
+//! time.
+//!
+//! In LAZY mode the query is instead evaluated on demand by an XPathEvaluator,
+//! so that each match is only found when the iterator is advanced to it. The
+//! document must not be modified whilst a lazy iterator is in use, and when
+//! constructed from a compiled expression, the expression must outlive the
+//! iterator.
 
 class XPathIterator : private Core::NotCopyable
 {
 public:
+	//! The evaluation modes.
+	enum Mode
+	{
+		EAGER,		//!< Find all the matches up front.
+		LAZY,		//!< Find each match as the iterator is advanced.
+	};
+
 	//! Default constructor.
 	XPathIterator();
 
 	//! Construction from a query and a context node.
-	XPathIterator(const tstring& query, const NodePtr& context);
+	XPathIterator(const tstring& query, const NodePtr& context, Mode mode = EAGER); // throw(InvalidArgException)
+
+	//! Construction from a compiled query and a context node.
+	XPathIterator(const XPathExpression& expression, const NodePtr& context, Mode mode = EAGER);
 
 	//! Destructor.
 	~XPathIterator();
@@ -55,32 +75,39 @@ private:
 	typedef std::vector<NodePtr> Nodes;
 	//! The results container iterator type.
 	typedef Nodes::const_iterator NodeIterator;
-	//! The query iterator type.
-	typedef tstring::const_iterator QueryIterator;
 
 	//
 	// Members.
 	//
-	tstring			m_query;		//!< The query.
-	NodePtr			m_context;		//!< The context XML node.
-	Nodes			m_results;		//!< The query results.
-	NodeIterator	m_currNode;		//!< The iterator into the query results.
+	Nodes					m_results;		//!< The query results.
+	NodeIterator			m_currNode;		//!< The iterator into the query results.
+	Mode					m_mode;			//!< The evaluation mode.
+	XPathExpression			m_compiled;		//!< The expression compiled from a query.
+	NodePtr					m_root;			//!< The root of the tree being lazily evaluated.
+	XPathEvaluator			m_evaluator;	//!< The lazy evaluation engine.
+	NodePtr					m_current;		//!< The current lazy match.
 
 	//
 	// Internal methods.
 	//
 
 	//! Start the iteration.
-	void start();
+	void start(const XPathExpression& expression, const NodePtr& context);
+
+	//! Start the lazy iteration.
+	void startLazy(const XPathExpression& expression, const NodePtr& context);
+
+	//! Find the next lazy match.
+	void findNext();
+
+	//! Query if the iterator is at the end of the sequence.
+	bool atEnd() const;
 
 	//! Continue the iteration.
 	void next();
 
 	//! End the iteration.
 	void reset();
-
-	//! Parse the next part of the query.
-	void parse(QueryIterator begin, QueryIterator end, const NodePtr& context);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathQuerySet.cpp
+//! \brief  The XPathQuerySet class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XPathQuerySet.hpp"
+#include "ElementNode.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+XPathQuerySet::XPathQuerySet()
+	: m_queries()
+	, m_states(2)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+XPathQuerySet::~XPathQuerySet()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a query, returning its index.
+
+size_t XPathQuerySet::add(const tstring& query_)
+{
+	return add(XPathExpression(query_));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a compiled query, returning its index. Any leading steps that are the
+//! same as those of an existing query share its states.
+
+size_t XPathQuerySet::add(const XPathExpression& expression)
+{
+	const size_t index = m_queries.size();
+
+	m_queries.push_back(expression);
+
+	// An empty relative query matches nothing.
+	if ( (!expression.isAbsolute()) && (expression.stepCount() == 0) )
+		return index;
+
+	size_t current = (expression.isAbsolute()) ? ABSOLUTE_ROOT : RELATIVE_ROOT;
+
+	for (size_t step = 0; step != expression.stepCount(); ++step)
+	{
+		size_t next = 0;
+
+		// Find an existing state for the same step.
+		for (size_t i = 0; (i != m_states[current].m_next.size()) && (next == 0); ++i)
+		{
+			const size_t candidate = m_states[current].m_next[i];
+
+			if (sameStep(m_states[candidate], expression, step))
+				next = candidate;
+		}
+
+		if (next == 0)
+		{
+			State state;
+
+			state.m_query = index;
+			state.m_step = step;
+
+			next = m_states.size();
+			m_states.push_back(state);
+			m_states[current].m_next.push_back(next);
+		}
+
+		current = next;
+	}
+
+	m_states[current].m_accepts.push_back(index);
+
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Evaluate all the queries against a context node. The results contain the
+//! matches for each query, in document order, by query index.
+
+void XPathQuerySet::evaluate(const NodePtr& context, Results& results) const
+{
+	results.clear();
+	results.resize(m_queries.size());
+
+	if (context.get() == nullptr)
+		return;
+
+	const Node* root = context.get();
+
+	// Search for the document root...
+	while (root->hasParent())
+		root = root->parentNode();
+
+	// Match both kinds of query in one walk from the root?
+	if (root == context.get())
+	{
+		walk(root, ABSOLUTE_ROOT, RELATIVE_ROOT+1, results);
+	}
+	else
+	{
+		walk(root, ABSOLUTE_ROOT, ABSOLUTE_ROOT+1, results);
+		walk(context.get(), RELATIVE_ROOT, RELATIVE_ROOT+1, results);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the location step for a state is equivalent to one in a query.
+
+bool XPathQuerySet::sameStep(const State& state, const XPathExpression& expression, size_t step) const
+{
+	const XPathExpression& existing = m_queries[state.m_query];
+	const size_t           index = state.m_step;
+
+	if ( (existing.stepAxis(index) != expression.stepAxis(step))
+	  || (existing.stepName(index) != expression.stepName(step))
+	  || (existing.stepPosition(index) != expression.stepPosition(step))
+	  || (existing.predicateCount(index) != expression.predicateCount(step)) )
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i != existing.predicateCount(index); ++i)
+	{
+		if ( (existing.predicateType(index, i) != expression.predicateType(step, i))
+		  || (existing.predicateName(index, i) != expression.predicateName(step, i))
+		  || (existing.predicateValue(index, i) != expression.predicateValue(step, i)) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Walk the tree below a node, matching from a range of root states. The walk
+//! uses an explicit stack and visits each node once, so the matches for each
+//! query are in document order with no duplicates.
+
+void XPathQuerySet::walk(const Node* start, size_t firstRoot, size_t lastRoot, Results& results) const
+{
+	ActiveStates active;
+
+	for (size_t root = firstRoot; root != lastRoot; ++root)
+	{
+		const State& rootState = m_states[root];
+
+		// Queries that match the start node itself, i.e. '/'.
+		for (size_t i = 0; i != rootState.m_accepts.size(); ++i)
+			results[rootState.m_accepts[i]].push_back(NodePtr(const_cast<Node*>(start), true));
+
+		for (size_t i = 0; i != rootState.m_next.size(); ++i)
+			addState(active, 0, rootState.m_next[i]);
+	}
+
+	const NodeContainer* nodes = NodeContainer::fromNode(start);
+
+	if ( (active.empty()) || (nodes == nullptr) )
+		return;
+
+	Frames frames;
+
+	Frame first = { nodes->firstChild().get(), 0 };
+
+	frames.push_back(first);
+
+	while (!frames.empty())
+	{
+		Frame&      frame = frames.back();
+		const Node* node = frame.m_next;
+
+		// All children visited?
+		if (node == nullptr)
+		{
+			active.resize(frame.m_active);
+			frames.pop_back();
+			continue;
+		}
+
+		frame.m_next = node->nextSibling().get();
+
+		if (node->type() != ELEMENT_NODE)
+			continue;
+
+		const ElementNode& element = *static_cast<const ElementNode*>(node);
+		const size_t       begin = frame.m_active;
+		const size_t       end = active.size();
+
+		// Find the states that the children of the node could match.
+		for (size_t i = begin; i != end; ++i)
+		{
+			const State&           state = m_states[active[i].m_state];
+			const XPathExpression& expression = m_queries[state.m_query];
+
+			if (expression.stepAxis(state.m_step) == XPathExpression::DESCENDANT)
+				addState(active, end, active[i].m_state);
+
+			if (!expression.selectsStep(state.m_step, element, active[i].m_matches))
+				continue;
+
+			for (size_t q = 0; q != state.m_accepts.size(); ++q)
+				results[state.m_accepts[q]].push_back(NodePtr(const_cast<Node*>(node), true));
+
+			for (size_t n = 0; n != state.m_next.size(); ++n)
+				addState(active, end, state.m_next[n]);
+		}
+
+		// Only descend if there is something left to match.
+		if ( (active.size() != end) && (element.hasChildren()) )
+		{
+			Frame child = { element.firstChild().get(), end };
+
+			frames.push_back(child);
+		}
+		else
+		{
+			active.resize(end);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a state to the set being built, if not already present.
+
+void XPathQuerySet::addState(ActiveStates& active, size_t begin, size_t state)
+{
+	for (size_t i = begin; i != active.size(); ++i)
+	{
+		if (active[i].m_state == state)
+			return;
+	}
+
+	Active entry = { state, 0 };
+
+	active.push_back(entry);
+}
+
+//namespace XML
+}
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathQuerySet.hpp
+//! \brief  The XPathQuerySet class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_XPATHQUERYSET_HPP
+#define XML_XPATHQUERYSET_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "XPathExpression.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A set of XPath queries that are evaluated together in a single pass over a
+//! document. The queries are compiled into one automaton where each state is
+//! a location step, and the queries that start with the same steps share the
+//! same states. Each open element holds the set of states its children could
+//! match next, so the tree is walked once however many queries there are,
+//! and a subtree is only skipped when no query can match anything in it.
+//!
+//! The absolute queries are evaluated from the document root and the relative
+//! ones from the context node. When the context is the root both are matched
+//! in the same walk, otherwise the context's subtree is walked a second time.
+
+class XPathQuerySet /*: private NotCopyable*/
+{
+public:
+	//! The container type used for the results of every query.
+	typedef std::vector<Nodes> Results;
+
+	//! Default constructor.
+	XPathQuerySet();
+
+	//! Destructor.
+	~XPathQuerySet();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of queries.
+	size_t queryCount() const;
+
+	//! Get the number of automaton states.
+	size_t stateCount() const;
+
+	//! Get a query.
+	const XPathExpression& query(size_t index) const;
+
+	//
+	// Methods.
+	//
+
+	//! Add a query, returning its index.
+	size_t add(const tstring& query); // throw(InvalidArgException)
+
+	//! Add a compiled query, returning its index.
+	size_t add(const XPathExpression& expression);
+
+	//! Evaluate all the queries against a context node.
+	void evaluate(const NodePtr& context, Results& results) const;
+
+private:
+	//! An automaton state, which matches a single location step.
+	struct State
+	{
+		size_t				m_query;	//!< The query that defines the step.
+		size_t				m_step;		//!< The step within the query.
+		std::vector<size_t>	m_next;		//!< The states that follow this one.
+		std::vector<size_t>	m_accepts;	//!< The queries matched by this state.
+	};
+
+	//! A state that the children of an open node can match.
+	struct Active
+	{
+		size_t		m_state;	//!< The automaton state.
+		size_t		m_matches;	//!< The number of children matched so far.
+	};
+
+	//! The state of an open node whose children are being visited.
+	struct Frame
+	{
+		const Node*	m_next;		//!< The next child node to visit.
+		size_t		m_active;	//!< The offset of the states the children can match.
+	};
+
+	//! The container type used for the queries.
+	typedef std::vector<XPathExpression> Queries;
+	//! The container type used for the automaton states.
+	typedef std::vector<State> States;
+	//! The container type used for the sets of active states.
+	typedef std::vector<Active> ActiveStates;
+	//! The stack of open nodes.
+	typedef std::vector<Frame> Frames;
+
+	//! The state all absolute queries start from.
+	static const size_t ABSOLUTE_ROOT = 0;
+	//! The state all relative queries start from.
+	static const size_t RELATIVE_ROOT = 1;
+
+	//
+	// Members.
+	//
+	Queries		m_queries;	//!< The queries.
+	States		m_states;	//!< The automaton states.
+
+	//
+	// Internal methods.
+	//
+
+	//! Query if two location steps are equivalent.
+	bool sameStep(const State& state, const XPathExpression& expression, size_t step) const;
+
+	//! Walk the tree below a node, matching from a range of root states.
+	void walk(const Node* start, size_t firstRoot, size_t lastRoot, Results& results) const;
+
+	//! Add a state to the set being built, if not already present.
+	static void addState(ActiveStates& active, size_t begin, size_t state);
+
+	// NotCopyable.
+	XPathQuerySet(const XPathQuerySet&);
+	XPathQuerySet& operator=(const XPathQuerySet);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of queries.
+
+inline size_t XPathQuerySet::queryCount() const
+{
+	return m_queries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of automaton states, including the two root states.
+
+inline size_t XPathQuerySet::stateCount() const
+{
+	return m_states.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a query.
+
+inline const XPathExpression& XPathQuerySet::query(size_t index) const
+{
+	ASSERT(index < m_queries.size());
+
+	return m_queries[index];
+}
+
+//namespace XML
+}
+
+#endif // XML_XPATHQUERYSET_HPP
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathStreamMatcher.cpp
+//! \brief  The XPathStreamMatcher class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XPathStreamMatcher.hpp"
+#include <Core/InvalidArgException.hpp>
+#include <Core/StringUtils.hpp>
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from the expression to match. The expression must outlive the
+//! matcher.
+
+XPathStreamMatcher::XPathStreamMatcher(const XPathExpression& expression)
+	: m_expression(expression)
+	, m_states()
+	, m_frames()
+{
+	bool supported = (expression.stepCount() != 0);
+
+	for (size_t step = 0; step != expression.stepCount(); ++step)
+	{
+		for (size_t i = 0; i != expression.predicateCount(step); ++i)
+		{
+			if (expression.predicateType(step, i) == XPathExpression::CHILD_EQUALS)
+				supported = false;
+		}
+	}
+
+	if (!supported)
+		throw Core::InvalidArgException(Core::fmt(TXT("The XPath expression '%s' cannot be matched whilst streaming"), expression.query().c_str()));
+
+	reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+XPathStreamMatcher::~XPathStreamMatcher()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reset the matcher ready for the start of a document, where the children of
+//! the document can match the first step.
+
+void XPathStreamMatcher::reset()
+{
+	m_states.clear();
+	m_frames.clear();
+
+	XPathEvaluator::addState(m_states, 0, 0);
+	m_frames.push_back(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match the start of an element, returning true if the element matches the
+//! entire expression.
+
+bool XPathStreamMatcher::enterElement(const ElementNode& element)
+{
+	ASSERT(!m_frames.empty());
+
+	const size_t first = m_frames.back();
+	const size_t last  = m_states.size();
+	const bool   matched = XPathEvaluator::advance(m_expression, m_states, first, element);
+
+	m_frames.push_back(last);
+
+	return matched;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match the end of the last element started.
+
+void XPathStreamMatcher::leaveElement()
+{
+	ASSERT(m_frames.size() > 1);
+
+	m_states.resize(m_frames.back());
+	m_frames.pop_back();
+}
+
+//namespace XML
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XPathStreamMatcher.hpp
+//! \brief  The XPathStreamMatcher class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef XML_XPATHSTREAMMATCHER_HPP
+#define XML_XPATHSTREAMMATCHER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "XPathEvaluator.hpp"
+
+namespace XML
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The class used to match an XPath expression against a stream of element
+//! start and end events, rather than a tree, so that it can be driven by the
+//! Reader whilst parsing. Each element is matched when it's started, before
+//! its children have been read, and so only the forward axes, name tests,
+//! attribute predicates and positions are supported.
+//!
+//! The expression is evaluated relative to the document, so absolute and
+//! relative expressions are equivalent. Each element is matched in the same way
+//! as by the XPathEvaluator, which it shares the sets of steps with.
+
+class XPathStreamMatcher /*: private NotCopyable*/
+{
+public:
+	//! Construction from the expression to match.
+	explicit XPathStreamMatcher(const XPathExpression& expression); // throw(InvalidArgException)
+
+	//! Destructor.
+	~XPathStreamMatcher();
+
+	//
+	// Methods.
+	//
+
+	//! Reset the matcher ready for the start of a document.
+	void reset();
+
+	//! Match the start of an element.
+	bool enterElement(const ElementNode& element);
+
+	//! Match the end of the last element started.
+	void leaveElement();
+
+private:
+	//! The container type used for the sets of steps.
+	typedef XPathEvaluator::States States;
+	//! The container type used for the offsets of the open elements sets.
+	typedef std::vector<size_t> Frames;
+
+	//
+	// Members.
+	//
+	const XPathExpression&	m_expression;	//!< The expression to match.
+	States					m_states;		//!< The sets of steps for the open elements.
+	Frames					m_frames;		//!< The offset of each open elements set.
+
+	// NotCopyable.
+	XPathStreamMatcher(const XPathStreamMatcher&);
+	XPathStreamMatcher& operator=(const XPathStreamMatcher);
+};
+
+//namespace XML
+}
+
+#endif // XML_XPATHSTREAMMATCHER_HPP